@@ -0,0 +1,132 @@
+/**
+ * a small harness for the benchmarks and checks of the containers
+ */
+#ifndef SJTU_BENCH_HPP
+#define SJTU_BENCH_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace bench {
+
+    typedef void (*function)();
+
+    /**
+     * registers a benchmark, or a check when check is true, before main runs.
+     * checks are quick and run by ctest, benchmarks only on demand
+     */
+    class registrar {
+    public:
+        registrar(const char *name, function run, bool check);
+    };
+
+    //wall clock time since construction
+    class timer {
+    private:
+        std::chrono::steady_clock::time_point start;
+
+    public:
+        timer() : start(std::chrono::steady_clock::now()) {}
+
+        double ms() const {
+            return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+    };
+
+    //xorshift, so that every run sees the same data
+    class random {
+    private:
+        uint64_t s;
+
+    public:
+        explicit random(uint64_t seed = 1) : s(seed * 0x9E3779B97F4A7C15ull + 1) {}
+
+        uint64_t operator()() {
+            s ^= s << 13;
+            s ^= s >> 7;
+            s ^= s << 17;
+            return s;
+        }
+
+        //uniform in [0, n)
+        uint64_t below(uint64_t n) {
+            return (*this)() % n;
+        }
+    };
+
+    //keeps a result alive, so that the work computing it is not optimized away
+    void keep(uint64_t value);
+
+    //one line of a table: the row, the column and a time
+    void report(const char *row, const char *column, double ms);
+
+    //one line of a table with a count instead of a time
+    void report_count(const char *row, const char *column, double count, const char *unit);
+
+    //calls of the global operator new on this thread so far
+    size_t allocations();
+
+    //bytes asked of the global operator new on this thread so far
+    size_t allocated_bytes();
+
+    //a failed check is printed and makes the run fail
+    void expect(bool condition, const char *what);
+
+    /**
+     * fn(arg) in a child process, whose allocator starts as the parent's did, and its result.
+     * node-based containers run markedly slower on memory that another container has freed
+     * in scattered order, so cells that compare them would otherwise depend on their order.
+     * runs in this process where fork is unavailable
+     */
+    template<class Function, class Arg>
+    double isolated(Function fn, const Arg &arg) {
+#if defined(__unix__) || defined(__APPLE__)
+        int channel[2];
+        if (pipe(channel) == 0) {
+            pid_t child = fork();
+            if (child == 0) {
+                close(channel[0]);
+                double res = fn(arg);
+                ssize_t written = write(channel[1], &res, sizeof(res));
+                _exit(written == (ssize_t) sizeof(res) ? 0 : 1);
+            }
+            close(channel[1]);
+            double res = 0;
+            bool done = child > 0 && read(channel[0], &res, sizeof(res)) == (ssize_t) sizeof(res);
+            close(channel[0]);
+            if (child > 0) waitpid(child, nullptr, 0);
+            if (done) return res;
+        }
+#endif
+        return fn(arg);
+    }
+
+    template<class Function>
+    double invoke(const Function &fn) {
+        return fn();
+    }
+
+    //fn() in a child process, as above
+    template<class Function>
+    double isolated(Function fn) {
+        return isolated(invoke<Function>, fn);
+    }
+
+}
+
+#define BENCH(name) \
+    static void name(); \
+    static bench::registrar name##_registrar(#name, name, false); \
+    static void name()
+
+#define CHECK(name) \
+    static void name(); \
+    static bench::registrar name##_registrar(#name, name, true); \
+    static void name()
+
+#endif
@@ -0,0 +1,81 @@
+#include "bench.hpp"
+#include "concurrent_map.hpp"
+#include "map.hpp"
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+    const uint64_t keyRange = 1000000;
+    const size_t opsPerThread = 1000000;
+
+    //what the lookup-heavy callers do today: one sjtu::map behind one mutex
+    class locked_map {
+    private:
+        std::mutex lock;
+        sjtu::map<uint64_t, uint64_t> m;
+
+    public:
+        bool find(uint64_t key, uint64_t &res) {
+            std::lock_guard<std::mutex> guard(lock);
+            sjtu::map<uint64_t, uint64_t>::iterator it = m.find(key);
+            if (it == m.end()) return false;
+            res = it->second;
+            return true;
+        }
+
+        void insert_or_assign(uint64_t key, uint64_t value) {
+            std::lock_guard<std::mutex> guard(lock);
+            m.insert_or_assign(key, value);
+        }
+
+        void erase(uint64_t key) {
+            std::lock_guard<std::mutex> guard(lock);
+            m.erase(key);
+        }
+    };
+
+    //99% find, 0.5% insert_or_assign and 0.5% erase of uniform random keys
+    template<class Map>
+    void worker(Map *m, uint64_t seed, uint64_t *hits) {
+        bench::random rng(seed);
+        uint64_t res = 0, found = 0;
+        for (size_t i = 0; i < opsPerThread; ++i) {
+            uint64_t key = rng.below(keyRange), op = rng.below(200);
+            if (op == 0) m->insert_or_assign(key, i);
+            else if (op == 1) m->erase(key);
+            else found += m->find(key, res);
+        }
+        *hits = found;
+    }
+
+    template<class Map>
+    void run(const char *column, Map &m, size_t threads) {
+        std::vector<std::thread> pool;
+        std::vector<uint64_t> hits(threads);
+        bench::timer t;
+        for (size_t i = 0; i < threads; ++i) pool.push_back(std::thread(worker<Map>, &m, i + 1, &hits[i]));
+        for (size_t i = 0; i < threads; ++i) pool[i].join();
+        double ms = t.ms();
+        std::string row = std::to_string(threads) + " threads, Mops/s";
+        bench::report_count(row.c_str(), column, threads * opsPerThread / ms / 1000, "");
+        for (size_t i = 0; i < threads; ++i) bench::keep(hits[i]);
+    }
+
+}
+
+BENCH(concurrent_map_scaling) {
+    sjtu::concurrent_map<uint64_t, uint64_t> sharded;
+    locked_map locked;
+    for (uint64_t k = 0; k < keyRange; ++k) {
+        sharded.insert_or_assign(k, k);
+        locked.insert_or_assign(k, k);
+    }
+    size_t cores = std::thread::hardware_concurrency(), most = cores > 4 ? cores : 4;
+    for (size_t threads = 1; threads <= most; threads <<= 1) {
+        run("concurrent_map", sharded, threads);
+        run("map with one mutex", locked, threads);
+    }
+}
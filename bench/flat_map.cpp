@@ -0,0 +1,38 @@
+#include "bench.hpp"
+#include "flat_map.hpp"
+#include "map.hpp"
+#include <utility>
+#include <vector>
+
+BENCH(flat_map_vs_map) {
+    const size_t n = 1000000;
+    bench::random rng(37);
+    std::vector<std::pair<uint64_t, uint64_t>> data(n);
+    for (size_t i = 0; i < n; ++i) data[i] = std::make_pair(rng(), i);
+    std::vector<uint64_t> order(n);
+    for (size_t i = 0; i < n; ++i) order[i] = data[rng.below(n)].first;
+
+    bench::timer t;
+    sjtu::flat_map<uint64_t, uint64_t> f(data.begin(), data.end());
+    bench::report("build from 1M unsorted", "flat_map", t.ms());
+    t = bench::timer();
+    sjtu::map<uint64_t, uint64_t> m;
+    for (size_t i = 0; i < n; ++i) m[data[i].first] = data[i].second;
+    bench::report("build from 1M unsorted", "map", t.ms());
+
+    uint64_t sum = 0;
+    t = bench::timer();
+    for (size_t i = 0; i < n; ++i) sum += f.at(order[i]);
+    bench::report("1M lookups", "flat_map", t.ms());
+    t = bench::timer();
+    for (size_t i = 0; i < n; ++i) sum += m.at(order[i]);
+    bench::report("1M lookups", "map", t.ms());
+
+    t = bench::timer();
+    for (sjtu::flat_map<uint64_t, uint64_t>::iterator it = f.begin(); it != f.end(); ++it) sum += (*it).second;
+    bench::report("scan of 1M", "flat_map", t.ms());
+    t = bench::timer();
+    for (sjtu::map<uint64_t, uint64_t>::iterator it = m.begin(); it != m.end(); ++it) sum += it->second;
+    bench::report("scan of 1M", "map", t.ms());
+    bench::keep(sum);
+}
@@ -0,0 +1,93 @@
+#include "bench.hpp"
+#include "flat_map.hpp"
+#include <map>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace {
+
+    //used as both key and value, it counts its instances and throws on the copy that brings countdown to 0
+    class counted {
+    public:
+        static long live, countdown;
+        long value;
+
+        counted(long value = 0) : value(value) { ++live; }
+
+        counted(const counted &other) : value(other.value) {
+            if (countdown > 0 && --countdown == 0) throw std::runtime_error("copy");
+            ++live;
+        }
+
+        counted(counted &&other) noexcept : value(other.value) { ++live; }
+
+        counted &operator=(const counted &other) = default;
+
+        counted &operator=(counted &&other) noexcept = default;
+
+        ~counted() { --live; }
+
+        bool operator<(const counted &rhs) const { return value < rhs.value; }
+    };
+
+    long counted::live = 0, counted::countdown = 0;
+
+    typedef sjtu::flat_map<counted, counted> counted_map;
+
+    bool same(const counted_map &m, const std::map<long, long> &ref) {
+        if (m.size() != ref.size()) return false;
+        std::map<long, long>::const_iterator r = ref.begin();
+        for (counted_map::const_iterator it = m.cbegin(); it != m.cend(); ++it, ++r)
+            if ((*it).first.value != r->first || (*it).second.value != r->second) return false;
+        return true;
+    }
+
+}
+
+CHECK(flat_map_copies) {
+    bench::random rng(37);
+    std::vector<std::pair<counted, counted>> data;
+    std::map<long, long> ref, otherRef;
+    for (long i = 0; i < 2000; ++i) {
+        long key = (long) rng.below(10000);
+        data.push_back(std::make_pair(counted(key), counted(i)));
+        ref.insert(std::make_pair(key, i));
+    }
+    {
+        counted_map m(data.begin(), data.end()), other;
+        for (long i = 0; i < 100; ++i) other[counted(-i)] = counted(i), otherRef[-i] = i;
+        bench::expect(same(m, ref), "a range build keeps the first of equal keys");
+        long live = counted::live;
+        //odd countdowns fail on a key, even ones on a value
+        for (long countdown = 1; countdown <= 4; ++countdown) {
+            counted::countdown = countdown * 300 + countdown % 2;
+            bool thrown = false;
+            try {
+                other = m;
+            } catch (std::runtime_error &) {
+                thrown = true;
+            }
+            counted::countdown = 0;
+            bench::expect(thrown, "the throwing copy is reported");
+            bench::expect(same(other, otherRef), "a failed copy assignment keeps the target");
+            bench::expect(counted::live == live, "a failed copy assignment leaks no element");
+            counted::countdown = countdown * 300 + countdown % 2;
+            thrown = false;
+            try {
+                counted_map copy(m);
+            } catch (std::runtime_error &) {
+                thrown = true;
+            }
+            counted::countdown = 0;
+            bench::expect(thrown && counted::live == live, "a failed copy construction leaks no element");
+        }
+        other = m;
+        bench::expect(same(other, ref) && same(m, ref), "copy assignment copies every element");
+        counted_map moved(std::move(other));
+        other = moved;
+        bench::expect(same(moved, ref) && same(other, ref), "a moved-from map can be assigned to");
+    }
+    data.clear();
+    bench::expect(counted::live == 0, "every key and value is destroyed");
+}
@@ -0,0 +1,77 @@
+/**
+ * synthetic graphs for the shortest-path benchmarks
+ */
+#ifndef SJTU_BENCH_GRAPH_HPP
+#define SJTU_BENCH_GRAPH_HPP
+
+#include "bench.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace bench {
+
+    /**
+     * a directed graph in compressed rows: the edges of v are [start[v], start[v + 1])
+     */
+    class graph {
+    public:
+        size_t vertices;
+        std::vector<size_t> start;
+        std::vector<uint32_t> to, weight;
+
+        //a cycle through every vertex, so all are reachable from 0, plus random edges up to edges in all
+        static graph random_graph(size_t vertices, size_t edges, uint64_t seed) {
+            bench::random rng(seed);
+            std::vector<uint32_t> from(edges), to(edges), weight(edges);
+            for (size_t e = 0; e < edges; ++e) {
+                from[e] = (uint32_t) (e < vertices ? e : rng.below(vertices));
+                to[e] = (uint32_t) (e < vertices ? (e + 1) % vertices : rng.below(vertices));
+                weight[e] = (uint32_t) rng.below(1000) + 1;
+            }
+            return graph(vertices, from, to, weight);
+        }
+
+        //a side by side grid of two-way roads between neighbours, each present with probability 9 / 10,
+        //of length 100 to 999: low degree and large diameter, like a road network
+        static graph grid(size_t side, uint64_t seed) {
+            bench::random rng(seed);
+            std::vector<uint32_t> from, to, weight;
+            for (size_t r = 0; r < side; ++r)
+                for (size_t c = 0; c < side; ++c) {
+                    uint32_t v = (uint32_t) (r * side + c);
+                    for (int down = 0; down < 2; ++down) {
+                        if (down ? r + 1 == side : c + 1 == side) continue;
+                        if (rng.below(10) == 0) continue;
+                        uint32_t u = (uint32_t) (down ? v + side : v + 1), w = (uint32_t) rng.below(900) + 100;
+                        from.push_back(v), to.push_back(u), weight.push_back(w);
+                        from.push_back(u), to.push_back(v), weight.push_back(w);
+                    }
+                }
+            return graph(side * side, from, to, weight);
+        }
+
+    private:
+        graph(size_t n, const std::vector<uint32_t> &from, const std::vector<uint32_t> &dest,
+              const std::vector<uint32_t> &cost) : vertices(n), start(n + 1, 0), to(from.size()), weight(from.size()) {
+            for (size_t e = 0; e < from.size(); ++e) ++start[from[e] + 1];
+            for (size_t v = 0; v < n; ++v) start[v + 1] += start[v];
+            std::vector<size_t> next(start.begin(), start.end() - 1);
+            for (size_t e = 0; e < from.size(); ++e) {
+                size_t slot = next[from[e]]++;
+                to[slot] = dest[e];
+                weight[slot] = cost[e];
+            }
+        }
+    };
+
+    //the sum of the distances from vertex 0 over the reachable vertices, to compare the runs
+    inline uint64_t distance_sum(const std::vector<uint64_t> &dist) {
+        uint64_t res = 0;
+        for (size_t v = 0; v < dist.size(); ++v)
+            if (dist[v] != UINT64_MAX) res += dist[v];
+        return res;
+    }
+
+}
+
+#endif
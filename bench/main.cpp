@@ -0,0 +1,107 @@
+#include "bench.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace bench {
+
+    namespace {
+        struct entry {
+            const char *name;
+            function run;
+            bool check;
+        };
+
+        const size_t maxEntries = 256;
+        entry entries[maxEntries];
+        size_t entryCount = 0;
+        size_t failures = 0;
+        volatile uint64_t sink = 0;
+        thread_local size_t allocationCount = 0, allocatedBytes = 0;
+    }
+
+    size_t allocations() {
+        return allocationCount;
+    }
+
+    size_t allocated_bytes() {
+        return allocatedBytes;
+    }
+
+    registrar::registrar(const char *name, function run, bool check) {
+        if (entryCount < maxEntries) entries[entryCount++] = entry{name, run, check};
+    }
+
+    void keep(uint64_t value) {
+        sink = sink + value;
+    }
+
+    void report(const char *row, const char *column, double ms) {
+        std::printf("  %-36s %-24s %10.1f ms\n", row, column, ms);
+        std::fflush(stdout);
+    }
+
+    void report_count(const char *row, const char *column, double count, const char *unit) {
+        //small counts are averages and keep two decimals
+        std::printf(count < 100 ? "  %-36s %-24s %10.2f %s\n" : "  %-36s %-24s %10.0f %s\n", row, column, count, unit);
+        std::fflush(stdout);
+    }
+
+    void expect(bool condition, const char *what) {
+        if (condition) return;
+        std::printf("  FAILED: %s\n", what);
+        ++failures;
+    }
+
+}
+
+//counted for bench::allocations and bench::allocated_bytes
+void *operator new(size_t n) {
+    ++bench::allocationCount;
+    bench::allocatedBytes += n;
+    void *res = std::malloc(n ? n : 1);
+    if (!res) throw std::bad_alloc();
+    return res;
+}
+
+void operator delete(void *ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+/**
+ * bench                run every benchmark
+ * bench name...        run the benchmarks and checks whose names contain one of the arguments
+ * bench --check        run every check
+ * bench --list         list the names
+ */
+int main(int argc, char *argv[]) {
+    using namespace bench;
+    bool checks = argc > 1 && !std::strcmp(argv[1], "--check");
+    bool list = argc > 1 && !std::strcmp(argv[1], "--list");
+    for (size_t i = 0; i < entryCount; ++i) {
+        const entry &e = entries[i];
+        bool selected;
+        if (list) {
+            std::printf("%s%s\n", e.name, e.check ? " (check)" : "");
+            continue;
+        }
+        if (checks) selected = e.check;
+        else if (argc == 1) selected = !e.check;
+        else {
+            selected = false;
+            for (int j = 1; j < argc; ++j)
+                if (std::strstr(e.name, argv[j])) selected = true;
+        }
+        if (!selected) continue;
+        std::printf("%s\n", e.name);
+        std::fflush(stdout);
+        e.run();
+    }
+    if (failures) std::printf("%zu checks failed\n", failures);
+    return failures ? 1 : 0;
+}
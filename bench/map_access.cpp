@@ -0,0 +1,96 @@
+#include "bench.hpp"
+#include "map.hpp"
+#include <vector>
+
+namespace {
+
+    //counts its calls, the comparator of every map below
+    class counting_less {
+    public:
+        static size_t calls;
+
+        bool operator()(uint64_t lhs, uint64_t rhs) const {
+            ++calls;
+            return lhs < rhs;
+        }
+    };
+
+    size_t counting_less::calls = 0;
+
+    typedef sjtu::map<uint64_t, uint64_t, counting_less> map_type;
+    typedef sjtu::pair<const uint64_t, uint64_t> value_type;
+
+    const size_t n = 1000000;
+
+    std::vector<uint64_t> shuffled(bench::random &rng) {
+        std::vector<uint64_t> keys(n);
+        for (size_t i = 0; i < n; ++i) keys[i] = i * 2;
+        for (size_t i = n - 1; i > 0; --i) {
+            size_t j = rng.below(i + 1);
+            uint64_t tmp = keys[i];
+            keys[i] = keys[j];
+            keys[j] = tmp;
+        }
+        return keys;
+    }
+
+    map_type filled(const std::vector<uint64_t> &keys) {
+        map_type m;
+        for (size_t i = 0; i < n; ++i) m[keys[i]] = i;
+        return m;
+    }
+
+    //comparisons per operation and the time of the n operations
+    class measure {
+    private:
+        const char *row;
+        bench::timer t;
+        size_t before;
+
+    public:
+        explicit measure(const char *row) : row(row), before(counting_less::calls) {}
+
+        ~measure() {
+            double ms = t.ms();
+            bench::report_count(row, "comparisons", (double) (counting_less::calls - before) / n, "per op");
+            bench::report(row, "time", ms);
+        }
+    };
+
+}
+
+BENCH(map_erase_and_subscript) {
+    bench::random rng(29);
+    std::vector<uint64_t> keys = shuffled(rng), order = shuffled(rng);
+    {
+        map_type m = filled(keys);
+        measure run("erase(find(key))");
+        for (size_t i = 0; i < n; ++i) m.erase(m.find(order[i]));
+    }
+    {
+        //what erase(iterator) used to cost: the node was found again from the root
+        map_type m = filled(keys);
+        measure run("find(key), then erase(key)");
+        for (size_t i = 0; i < n; ++i) {
+            bench::keep(m.find(order[i]) != m.end());
+            m.erase(order[i]);
+        }
+    }
+    {
+        map_type m = filled(keys);
+        measure run("erase(key)");
+        for (size_t i = 0; i < n; ++i) m.erase(order[i]);
+    }
+    {
+        map_type m;
+        measure run("operator[] on new keys");
+        for (size_t i = 0; i < n; ++i) m[keys[i]] = i;
+    }
+    {
+        //what operator[] used to cost on a miss: a lookup, then an insert from the root
+        map_type m;
+        measure run("count(key), then insert");
+        for (size_t i = 0; i < n; ++i)
+            if (!m.count(keys[i])) m.insert(value_type(keys[i], i));
+    }
+}
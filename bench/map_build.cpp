@@ -0,0 +1,46 @@
+#include "bench.hpp"
+#include "map.hpp"
+#include <vector>
+
+namespace {
+
+    typedef sjtu::map<uint64_t, uint64_t> map_type;
+    typedef sjtu::pair<const uint64_t, uint64_t> value_type;
+
+}
+
+BENCH(map_from_sorted) {
+    const size_t n = 1000000;
+    std::vector<value_type> snapshot;
+    snapshot.reserve(n);
+    for (size_t i = 0; i < n; ++i) snapshot.push_back(value_type(i * 3, i));
+    {
+        bench::timer t;
+        map_type m;
+        for (size_t i = 0; i < n; ++i) m.insert(snapshot[i]);
+        bench::report("1M sorted pairs", "insert one by one", t.ms());
+        bench::keep(m.size());
+    }
+    {
+        bench::timer t;
+        map_type m = map_type::from_sorted(snapshot.begin(), snapshot.end());
+        bench::report("1M sorted pairs", "from_sorted", t.ms());
+        bench::keep(m.size());
+    }
+    //half of the map is loaded, the other half arrives as a sorted batch beyond the last key
+    map_type base = map_type::from_sorted(snapshot.begin(), snapshot.begin() + n / 2);
+    {
+        map_type m(base);
+        bench::timer t;
+        for (size_t i = n / 2; i < n; ++i) m.insert(snapshot[i]);
+        bench::report("500K appended to 500K", "insert one by one", t.ms());
+        bench::keep(m.size());
+    }
+    {
+        map_type m(base);
+        bench::timer t;
+        m.merge_sorted(snapshot.begin() + n / 2, snapshot.end());
+        bench::report("500K appended to 500K", "merge_sorted", t.ms());
+        bench::keep(m.size());
+    }
+}
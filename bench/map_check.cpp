@@ -0,0 +1,566 @@
+#include "bench.hpp"
+#include "concurrent_map.hpp"
+#include "map.hpp"
+#include "map_view.hpp"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include <unistd.h>
+
+namespace {
+
+    typedef std::map<long, long> reference;
+
+    //fill m and ref with the same n random keys below range.
+    //values assigned in place are refreshed, so a map with a Monoid keeps its summaries
+    template<class Map>
+    void fill(Map &m, reference &ref, size_t n, long range, bench::random &rng) {
+        for (size_t i = 0; i < n; ++i) {
+            long key = (long) rng.below(range), value = (long) rng.below(1000);
+            m[key] = value, ref[key] = value;
+            m.refresh(m.find(key));
+        }
+    }
+
+    template<class Map>
+    bool same(const Map &m, const reference &ref) {
+        if (m.size() != ref.size()) return false;
+        typename Map::const_iterator it = m.cbegin();
+        for (reference::const_iterator r = ref.begin(); r != ref.end(); ++r, ++it)
+            if (it == m.cend() || it->first != r->first || it->second != r->second) return false;
+        return it == m.cend();
+    }
+
+    //one random insertion or erasure below range on both m and ref, through every path of map
+    template<class Map>
+    void mutate(Map &m, reference &ref, long range, bench::random &rng) {
+        typedef typename Map::value_type value_type;
+        long key = (long) rng.below(range), value = (long) rng.below(1000);
+        switch (rng.below(8)) {
+            case 0:
+                m[key] = value, ref[key] = value;
+                m.refresh(m.find(key));
+                break;
+            case 1:
+                m.insert(value_type(key, value)), ref.insert(std::make_pair(key, value));
+                break;
+            case 2:
+                m.try_emplace(key, value), ref.insert(std::make_pair(key, value));
+                break;
+            case 3:
+                m.insert(m.lower_bound(key), value_type(key, value)), ref.insert(std::make_pair(key, value));
+                break;
+            case 4:
+            case 5:
+                bench::expect(m.erase(key) == ref.erase(key), "erase(key) counts the erased element");
+                break;
+            case 6: {
+                typename Map::iterator it = m.lower_bound(key);
+                if (it == m.end()) break;
+                ref.erase(it->first);
+                m.erase(it);
+                break;
+            }
+            default: {
+                long hi = key + (long) rng.below(range / 100 + 1);
+                m.erase(m.lower_bound(key), m.lower_bound(hi));
+                ref.erase(ref.lower_bound(key), ref.lower_bound(hi));
+            }
+        }
+    }
+
+    //the key at it, or -1 for end
+    template<class Map, class Iterator>
+    long keyAt(const Map &m, const Iterator &it) {
+        return it == m.cend() ? -1 : it->first;
+    }
+
+    long keyAt(const reference &ref, reference::const_iterator it) {
+        return it == ref.end() ? -1 : it->first;
+    }
+
+    class collect {
+    public:
+        std::vector<long> *keys;
+
+        template<class Record>
+        void operator()(const Record &record) const {
+            keys->push_back(record.first);
+        }
+    };
+
+    template<class Map>
+    void check_bounds() {
+        bench::random rng(26);
+        Map m;
+        reference ref;
+        fill(m, ref, 3000, 10000, rng);
+        const Map &cm = m;
+        for (size_t i = 0; i < 20000; ++i) {
+            long key = (long) rng.below(10002) - 1;
+            long lower = keyAt(ref, ref.lower_bound(key)), upper = keyAt(ref, ref.upper_bound(key));
+            bench::expect(keyAt(m, m.lower_bound(key)) == lower, "lower_bound matches std::map");
+            bench::expect(keyAt(m, cm.lower_bound(key)) == lower, "const lower_bound matches std::map");
+            bench::expect(keyAt(m, m.upper_bound(key)) == upper, "upper_bound matches std::map");
+            bench::expect(keyAt(m, cm.upper_bound(key)) == upper, "const upper_bound matches std::map");
+            sjtu::pair<typename Map::iterator, typename Map::iterator> range = m.equal_range(key);
+            bench::expect(keyAt(m, range.first) == lower && keyAt(m, range.second) == upper,
+                          "equal_range is lower_bound and upper_bound");
+            long hi = key + (long) rng.below(200);
+            std::vector<long> expected, visited, visitedConst;
+            for (reference::const_iterator it = ref.lower_bound(key); it != ref.lower_bound(hi); ++it)
+                expected.push_back(it->first);
+            m.for_each_in_range(key, hi, collect{&visited});
+            cm.for_each_in_range(key, hi, collect{&visitedConst});
+            bench::expect(visited == expected && visitedConst == expected, "for_each_in_range visits [lo, hi) in order");
+        }
+        bench::expect(same(m, ref), "the map holds the same elements as std::map");
+        Map empty;
+        bench::expect(empty.lower_bound(0) == empty.end() && empty.upper_bound(0) == empty.end(),
+                      "bounds of an empty map are end()");
+    }
+
+    template<class Map>
+    void check_order_statistic() {
+        bench::random rng(28);
+        Map m;
+        reference ref;
+        fill(m, ref, 2000, 6000, rng);
+        for (size_t step = 1; step <= 30000; ++step) {
+            mutate(m, ref, 6000, rng);
+            if (step % 1000 == 0) {
+                bench::expect(m.valid(), "the tree keeps its invariants and sizes");
+                bench::expect(same(m, ref), "the map holds the same elements as std::map");
+            }
+            if (ref.empty()) continue;
+            size_t n = ref.size(), k = (size_t) rng.below(n);
+            reference::const_iterator kth = ref.begin();
+            std::advance(kth, k);
+            typename Map::iterator it = m.select(k);
+            bench::expect(it->first == kth->first, "select(k) is the k-th smallest");
+            long key = (long) rng.below(6002) - 1;
+            bench::expect(m.rank(key) == (size_t) std::distance(ref.begin(), ref.lower_bound(key)),
+                          "rank counts the smaller keys");
+            int d = (int) rng.below(n + 1) - (int) k;
+            reference::const_iterator moved = kth;
+            std::advance(moved, d);
+            bench::expect(keyAt(m, it + d) == keyAt(ref, moved), "iterator + n moves n elements");
+            typename Map::const_iterator cit = it + d;
+            bench::expect(keyAt(m, cit - d) == kth->first, "const_iterator - n moves back");
+            bool thrown = false;
+            try {
+                it + (int) (n - k + 1);
+            } catch (sjtu::invalid_iterator &) {
+                thrown = true;
+            }
+            bench::expect(thrown, "iterator + n beyond end() throws invalid_iterator");
+        }
+        bench::expect(m.valid() && same(m, ref), "the map holds the same elements as std::map");
+        bool thrown = false;
+        try {
+            m.select(m.size());
+        } catch (sjtu::index_out_of_bound &) {
+            thrown = true;
+        }
+        bench::expect(thrown, "select(size()) throws index_out_of_bound");
+    }
+
+    //op 0 to 3 is set_union, set_intersection, set_difference and split on a map of n keys and one of m
+    template<class Map, class Fork>
+    void check_set_operation(int op, size_t n, size_t m, const Fork &fork, bench::random &rng) {
+        long range = (long) (n + m) * 2 + 1;
+        Map a, b;
+        reference refA, refB, expected;
+        fill(a, refA, n, range, rng);
+        fill(b, refB, m, range, rng);
+        long key = (long) rng.below(range);
+        if (op == 0) {
+            expected = refA;
+            expected.insert(refB.begin(), refB.end());
+            a.set_union(b, fork);
+        } else if (op == 1) {
+            for (reference::const_iterator it = refA.begin(); it != refA.end(); ++it)
+                if (refB.count(it->first)) expected.insert(*it);
+            a.set_intersection(b, fork);
+        } else if (op == 2) {
+            for (reference::const_iterator it = refA.begin(); it != refA.end(); ++it)
+                if (!refB.count(it->first)) expected.insert(*it);
+            a.set_difference(b, fork);
+        } else {
+            expected.insert(refA.begin(), refA.lower_bound(key));
+            refB = reference(refA.lower_bound(key), refA.end());
+            a.split(key, b);
+        }
+        bench::expect(a.valid() && same(a, expected), "a set operation leaves the expected elements");
+        if (op < 3) bench::expect(b.valid() && b.empty() && b.begin() == b.end(), "a set operation empties other");
+        else bench::expect(b.valid() && same(b, refB), "split moves the greater keys into right");
+        //both stay usable
+        for (size_t i = 0; i < 200; ++i) mutate(a, expected, range, rng);
+        bench::expect(a.valid() && same(a, expected), "a map works after a set operation");
+    }
+
+    //map_thread_fork counting the forks it is asked for
+    class counted_fork {
+    public:
+        sjtu::map_thread_fork *fork;
+        std::atomic<size_t> *calls;
+
+        template<class F, class G>
+        void operator()(F f, G g) const {
+            ++*calls;
+            (*fork)(f, g);
+        }
+    };
+
+    template<class Map>
+    void check_set_operations() {
+        bench::random rng(34);
+        const size_t sizes[][2] = {{0, 500}, {500, 0}, {1, 1}, {300, 3000}, {3000, 300}, {2000, 2000}, {5000, 40}};
+        for (int op = 0; op < 4; ++op)
+            for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i)
+                for (int repeat = 0; repeat < 3; ++repeat)
+                    check_set_operation<Map>(op, sizes[i][0], sizes[i][1], sjtu::map_sequential_fork(), rng);
+        //trees high enough to be forked onto threads
+        sjtu::map_thread_fork threads(4);
+        std::atomic<size_t> calls(0);
+        counted_fork fork = {&threads, &calls};
+        for (int op = 0; op < 3; ++op) check_set_operation<Map>(op, 60000, 50000, fork, rng);
+        bench::expect(calls > 0, "large set operations fork");
+    }
+
+    //the sum of the values of the keys in [lo, hi], the way aggregate() should see it
+    long sumOf(const reference &ref, long lo, long hi) {
+        long sum = 0;
+        if (lo > hi) return sum;
+        for (reference::const_iterator it = ref.lower_bound(lo); it != ref.upper_bound(hi); ++it) sum += it->second;
+        return sum;
+    }
+
+    template<class Map>
+    void check_aggregate() {
+        bench::random rng(38);
+        Map m;
+        reference ref;
+        fill(m, ref, 2000, 6000, rng);
+        for (size_t step = 1; step <= 30000; ++step) {
+            mutate(m, ref, 6000, rng);
+            long key = (long) rng.below(6000), value = (long) rng.below(1000);
+            switch (rng.below(4)) {
+                case 0: {
+                    //changed in place, then refreshed
+                    typename Map::iterator it = m.lower_bound(key);
+                    if (it == m.end()) break;
+                    it->second = value, ref[it->first] = value;
+                    m.refresh(it);
+                    break;
+                }
+                case 1:
+                    m[key] = value, ref[key] = value;
+                    m.refresh(m.find(key));
+                    break;
+                case 2:
+                    m.insert_or_assign(key, value), ref[key] = value;
+                    break;
+            }
+            long lo = (long) rng.below(6002) - 1, hi = lo + (long) rng.below(1000) - 100;
+            bench::expect(m.aggregate(lo, hi) == sumOf(ref, lo, hi), "aggregate sums the values in [lo, hi]");
+            if (step % 1000 == 0)
+                bench::expect(m.valid() && same(m, ref), "the map keeps its invariants, summaries and elements");
+        }
+        //set operations, split and merge_sorted rebuild the summaries of the trees they join
+        for (int op = 0; op < 4; ++op) {
+            Map a, b;
+            reference refA, refB;
+            fill(a, refA, 3000, 8000, rng);
+            fill(b, refB, 2000, 8000, rng);
+            if (op == 0) {
+                a.set_union(b);
+                refA.insert(refB.begin(), refB.end());
+            } else if (op == 1) {
+                a.set_difference(b);
+                for (reference::const_iterator it = refB.begin(); it != refB.end(); ++it) refA.erase(it->first);
+            } else if (op == 2) {
+                a.split(4000, b);
+                refB = reference(refA.lower_bound(4000), refA.end());
+                refA.erase(refA.lower_bound(4000), refA.end());
+                bench::expect(b.valid() && b.aggregate(0, 8000) == sumOf(refB, 0, 8000), "split summarizes right");
+            } else {
+                std::vector<std::pair<long, long>> tail;
+                for (long key = 8000; key < 9000; key += 3) tail.push_back(std::make_pair(key, key % 7));
+                a.merge_sorted(tail.begin(), tail.end());
+                refA.insert(tail.begin(), tail.end());
+            }
+            bench::expect(a.valid() && same(a, refA), "a set operation keeps the summaries");
+            for (size_t i = 0; i < 100; ++i) {
+                long lo = (long) rng.below(9000), hi = lo + (long) rng.below(3000);
+                bench::expect(a.aggregate(lo, hi) == sumOf(refA, lo, hi), "aggregate works after a set operation");
+            }
+        }
+        bool thrown = false;
+        try {
+            m.refresh(m.end());
+        } catch (sjtu::invalid_iterator &) {
+            thrown = true;
+        }
+        bench::expect(thrown, "refresh(end()) throws invalid_iterator");
+    }
+
+    //whether f throws E
+    template<class E, class F>
+    bool throws(F f) {
+        try {
+            f();
+        } catch (E &) {
+            return true;
+        }
+        return false;
+    }
+
+    template<class Map>
+    void check_save_load() {
+        bench::random rng(40);
+        Map m;
+        reference ref;
+        fill(m, ref, 5000, 20000, rng);
+        std::stringstream stream;
+        m.save(stream);
+        std::string data = stream.str();
+        Map loaded;
+        loaded[-5] = 5;
+        loaded.load(stream);
+        bench::expect(loaded.valid() && same(loaded, ref), "load restores the saved elements");
+        for (size_t i = 0; i < 200; ++i) mutate(loaded, ref, 20000, rng);
+        bench::expect(loaded.valid() && same(loaded, ref), "a loaded map works");
+        //cut inside the header and inside the records
+        const size_t cuts[] = {0, 16, sizeof(sjtu::map_header), sizeof(sjtu::map_header) + 5, data.size() / 2, data.size() - 1};
+        for (size_t i = 0; i < sizeof(cuts) / sizeof(cuts[0]); ++i) {
+            std::stringstream cut(data.substr(0, cuts[i]));
+            bench::expect(throws<sjtu::runtime_error>([&] { loaded.load(cut); }), "a truncated stream throws runtime_error");
+            bench::expect(loaded.empty() && loaded.valid(), "a failed load leaves the map empty");
+        }
+        std::stringstream wrong(data);
+        sjtu::map<int, long> other;
+        bench::expect(throws<sjtu::runtime_error>([&] { other.load(wrong); }), "a header of other types throws runtime_error");
+        std::stringstream broken(data);
+        broken.seekp(0);
+        broken.write("SJTUMAQ", 8);
+        bench::expect(throws<sjtu::runtime_error>([&] { loaded.load(broken); }), "a wrong magic throws runtime_error");
+    }
+
+    //write data to a new temporary file, return its path
+    std::string temporary(const std::string &data) {
+        char path[] = "/tmp/map_check_XXXXXX";
+        int fd = mkstemp(path);
+        bench::expect(fd >= 0, "a temporary file is created");
+        close(fd);
+        std::ofstream os(path, std::ios::binary);
+        os.write(data.data(), data.size());
+        return path;
+    }
+
+    void check_view() {
+        typedef sjtu::map<long, long, std::less<long>, true> Map;
+        typedef sjtu::map_view<long, long> view_type;
+        bench::random rng(401);
+        Map m;
+        reference ref;
+        fill(m, ref, 20000, 100000, rng);
+        std::stringstream stream;
+        m.save(stream);
+        std::string data = stream.str(), path = temporary(data);
+        {
+            view_type view(path.c_str());
+            bench::expect(view.size() == m.size() && !view.empty(), "the view holds every element");
+            for (size_t i = 0; i < 20000; ++i) {
+                long key = (long) rng.below(100002) - 1, value = -1;
+                bool found = view.find(key, value);
+                Map::iterator it = m.find(key);
+                bench::expect(found == (it != m.end()) && view.count(key) == m.count(key), "find and count match the map");
+                if (found) bench::expect(value == it->second && view.at(key) == it->second, "find and at read the value");
+                else bench::expect(throws<sjtu::index_out_of_bound>([&] { view.at(key); }), "at throws for a missing key");
+                bench::expect(view.rank(key) == m.rank(key), "rank matches the map");
+                size_t k = rng.below(m.size());
+                sjtu::pair<long, long> record = view.record(k);
+                bench::expect(record.first == m.select(k)->first && record.second == m.select(k)->second,
+                              "record(i) is the i-th smallest");
+            }
+            bench::expect(throws<sjtu::index_out_of_bound>([&] { view.record(view.size()); }),
+                          "record(size()) throws index_out_of_bound");
+        }
+        std::remove(path.c_str());
+        //a file cut inside the header or the records, of other types, or missing
+        const size_t cuts[] = {0, 16, data.size() - 1};
+        for (size_t i = 0; i < sizeof(cuts) / sizeof(cuts[0]); ++i) {
+            path = temporary(data.substr(0, cuts[i]));
+            bench::expect(throws<sjtu::runtime_error>([&] { view_type view(path.c_str()); }),
+                          "a truncated file throws runtime_error");
+            std::remove(path.c_str());
+        }
+        path = temporary(data);
+        bench::expect(throws<sjtu::runtime_error>([&] { sjtu::map_view<int, long> view(path.c_str()); }),
+                      "a header of other types throws runtime_error");
+        std::remove(path.c_str());
+        bench::expect(throws<sjtu::runtime_error>([&] { view_type view(path.c_str()); }),
+                      "a missing file throws runtime_error");
+        Map empty;
+        std::stringstream emptyStream;
+        empty.save(emptyStream);
+        path = temporary(emptyStream.str());
+        {
+            view_type view(path.c_str());
+            long value;
+            bench::expect(view.empty() && !view.find(0, value) && view.rank(0) == 0, "an empty map opens as an empty view");
+        }
+        std::remove(path.c_str());
+    }
+
+    //a value that counts its instances and throws on the copy that brings countdown to 0
+    class fragile {
+    public:
+        static long live, countdown;
+        long value;
+
+        fragile(long value = 0) : value(value) { ++live; }
+
+        fragile(const fragile &other) : value(other.value) {
+            if (countdown > 0 && --countdown == 0) throw std::runtime_error("copy");
+            ++live;
+        }
+
+        fragile &operator=(const fragile &other) {
+            value = other.value;
+            return *this;
+        }
+
+        ~fragile() { --live; }
+    };
+
+    long fragile::live = 0, fragile::countdown = 0;
+
+    template<bool CompactNode>
+    void check_sorted_build() {
+        typedef sjtu::map<long, long, std::less<long>, false, CompactNode> Map;
+        typedef sjtu::map<long, fragile, std::less<long>, false, CompactNode> fragile_map;
+        bench::random rng(27);
+        std::vector<std::pair<long, long>> sorted;
+        for (long key = 0; key < 5000; key += (long) rng.below(3))
+            sorted.push_back(std::make_pair(key, (long) rng.below(1000)));
+        reference ref;
+        for (size_t i = 0; i < sorted.size(); ++i) ref.insert(sorted[i]);
+        Map m = Map::from_sorted(sorted.begin(), sorted.end());
+        bench::expect(same(m, ref), "from_sorted keeps the first of equal keys");
+        //an unsorted tail falls back to insert, and merge_sorted appends beyond the largest key
+        std::vector<std::pair<long, long>> tail;
+        for (size_t i = 0; i < 2000; ++i) {
+            long key = (long) (i < 1000 ? 5000 + i * 2 : rng.below(8000));
+            tail.push_back(std::make_pair(key, (long) i));
+            ref.insert(tail.back());
+        }
+        m.merge_sorted(tail.begin(), tail.end());
+        bench::expect(same(m, ref), "merge_sorted appends and inserts the unsorted tail");
+
+        //a copy throwing halfway leaves the map as it was and leaks nothing
+        std::vector<std::pair<long, fragile>> values;
+        for (long key = 0; key < 1000; ++key) values.push_back(std::make_pair(key, fragile(key)));
+        for (int prefilled = 0; prefilled < 2; ++prefilled) {
+            long before = fragile::live;
+            {
+                fragile_map f;
+                if (prefilled) f.merge_sorted(values.begin(), values.begin() + 10);
+                fragile::countdown = 500;
+                bool thrown = false;
+                try {
+                    f.merge_sorted(values.begin() + 10, values.end());
+                } catch (std::runtime_error &) {
+                    thrown = true;
+                }
+                fragile::countdown = 0;
+                bench::expect(thrown, "the throwing copy is reported");
+                bench::expect(f.size() == (size_t) (prefilled ? 10 : 0), "a failed merge_sorted keeps the old elements");
+                size_t n = 0;
+                for (typename fragile_map::iterator it = f.begin(); it != f.end(); ++it) ++n;
+                bench::expect(n == f.size(), "a failed merge_sorted keeps the iteration intact");
+                f.merge_sorted(values.begin() + 10, values.end());
+                bench::expect(f.size() == (size_t) (prefilled ? 1000 : 990), "the map works after a failed merge_sorted");
+            }
+            bench::expect(fragile::live == before, "a failed merge_sorted leaks no element");
+        }
+    }
+
+}
+
+CHECK(map_bounds) {
+    check_bounds<sjtu::map<long, long>>();
+    check_bounds<sjtu::map<long, long, std::less<long>, true>>();
+    check_bounds<sjtu::map<long, long, std::less<long>, false, true>>();
+}
+
+CHECK(map_order_statistic) {
+    check_order_statistic<sjtu::map<long, long, std::less<long>, true>>();
+    check_order_statistic<sjtu::map<long, long, std::less<long>, true, true>>();
+}
+
+//plain and CompactNode maps through the same mixed operations
+CHECK(map_invariants) {
+    bench::random rng(281);
+    sjtu::map<long, long> plain;
+    sjtu::map<long, long, std::less<long>, false, true> compact;
+    reference plainRef, compactRef;
+    for (size_t step = 1; step <= 60000; ++step) {
+        mutate(plain, plainRef, 4000, rng);
+        mutate(compact, compactRef, 4000, rng);
+        if (step % 2000 == 0) {
+            bench::expect(plain.valid() && same(plain, plainRef), "the map keeps its invariants and elements");
+            bench::expect(compact.valid() && same(compact, compactRef),
+                          "the CompactNode map keeps its invariants and elements");
+        }
+    }
+}
+
+CHECK(map_set_operations) {
+    check_set_operations<sjtu::map<long, long>>();
+    check_set_operations<sjtu::map<long, long, std::less<long>, true>>();
+    check_set_operations<sjtu::map<long, long, std::less<long>, false, true>>();
+}
+
+CHECK(map_aggregate) {
+    check_aggregate<sjtu::aggregate_map<long, long, sjtu::map_sum<long>>>();
+    check_aggregate<sjtu::map<long, long, std::less<long>, true, true, sjtu::map_sum<long>>>();
+}
+
+CHECK(map_save_load) {
+    check_save_load<sjtu::map<long, long>>();
+    check_save_load<sjtu::map<long, long, std::less<long>, false, true>>();
+    //variable-length values
+    sjtu::map<long, std::string> m, loaded;
+    bench::random rng(402);
+    for (long i = 0; i < 3000; ++i) m[(long) rng.below(10000)] = std::string(rng.below(300), (char) ('a' + i % 26));
+    std::stringstream stream;
+    m.save(stream);
+    loaded.load(stream);
+    bool equal = loaded.size() == m.size() && loaded.valid();
+    for (sjtu::map<long, std::string>::const_iterator it = m.cbegin(); equal && it != m.cend(); ++it)
+        equal = loaded.count(it->first) && loaded.at(it->first) == it->second;
+    bench::expect(equal, "strings are saved and loaded");
+    std::string data = stream.str();
+    std::stringstream cut(data.substr(0, data.size() - 100));
+    bench::expect(throws<sjtu::runtime_error>([&] { loaded.load(cut); }) && loaded.empty(),
+                  "a truncated string throws runtime_error");
+}
+
+CHECK(map_view) {
+    check_view();
+}
+
+CHECK(map_sorted_build) {
+    check_sorted_build<false>();
+    check_sorted_build<true>();
+}
@@ -0,0 +1,51 @@
+#include "bench.hpp"
+#include "map.hpp"
+#include <vector>
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+#include <malloc.h>
+#define BENCH_HEAP_IN_USE
+#endif
+
+namespace {
+
+    const size_t n = 1000000;
+
+    //bytes the allocator holds for the program, including its own overhead, 0 where unknown
+    size_t heap_in_use() {
+#ifdef BENCH_HEAP_IN_USE
+        return mallinfo2().uordblks;
+#else
+        return 0;
+#endif
+    }
+
+    //memory of a map<int, int> of 1M random keys and the time of a full in-order iteration
+    template<bool CompactNode>
+    void run(const char *column, const std::vector<int> &keys) {
+        size_t bytes = bench::allocated_bytes(), heap = heap_in_use();
+        sjtu::map<int, int, std::less<int>, false, CompactNode> m;
+        for (size_t i = 0; i < n; ++i) m[keys[i]] = (int) i;
+        double perEntry = (double) (bench::allocated_bytes() - bytes) / m.size();
+        bench::report_count("bytes allocated per entry", column, perEntry, "");
+        if (heap_in_use()) bench::report_count("MB heap in use per 1M entries", column,
+                                               (double) (heap_in_use() - heap) * 1000000 / m.size() / (1 << 20), "");
+        const size_t passes = 10;
+        uint64_t sum = 0;
+        bench::timer t;
+        for (size_t pass = 0; pass < passes; ++pass)
+            for (typename sjtu::map<int, int, std::less<int>, false, CompactNode>::const_iterator it = m.cbegin();
+                 it != m.cend(); ++it)
+                sum += it->second;
+        bench::report("in-order iteration, one pass", column, t.ms() / passes);
+        bench::keep(sum);
+    }
+
+}
+
+BENCH(map_compact_node) {
+    bench::random rng(30);
+    std::vector<int> keys(n);
+    for (size_t i = 0; i < n; ++i) keys[i] = (int) (rng() >> 33);
+    run<false>("threaded", keys);
+    run<true>("CompactNode", keys);
+}
@@ -0,0 +1,65 @@
+#include "bench.hpp"
+#include "map.hpp"
+#include <string>
+#include <vector>
+
+namespace {
+
+    //a stateful less-than on strings: it counts its calls in a counter it points to
+    class counting_less {
+    public:
+        size_t *calls;
+
+        explicit counting_less(size_t *calls = nullptr) : calls(calls) {}
+
+        bool operator()(const std::string &lhs, const std::string &rhs) const {
+            ++*calls;
+            return lhs < rhs;
+        }
+    };
+
+    //the same order with a three-way member, so that map calls it once per level
+    class counting_three_way : public counting_less {
+    public:
+        explicit counting_three_way(size_t *calls = nullptr) : counting_less(calls) {}
+
+        int compare(const std::string &lhs, const std::string &rhs) const {
+            ++*calls;
+            return lhs.compare(rhs);
+        }
+    };
+
+    const size_t n = 100000;
+
+    template<class Compare>
+    void run(const char *row, const std::vector<std::string> &keys) {
+        size_t calls = 0, before;
+        sjtu::map<std::string, size_t, Compare> m((Compare(&calls)));
+        std::string name;
+        bench::timer t;
+        for (size_t i = 0; i < n; ++i) m[keys[i]] = i;
+        name = std::string(row) + ", insert";
+        bench::report_count(name.c_str(), "comparisons", (double) calls / n, "per op");
+        before = calls;
+        size_t found = 0;
+        for (size_t i = n; i-- > 0;) found += m.count(keys[i]);
+        name = std::string(row) + ", find";
+        bench::report_count(name.c_str(), "comparisons", (double) (calls - before) / n, "per op");
+        before = calls;
+        for (size_t i = 0; i < n; i += 2) m.erase(keys[i]);
+        name = std::string(row) + ", erase";
+        bench::report_count(name.c_str(), "comparisons", (double) (calls - before) / (n / 2), "per op");
+        bench::report(row, "time", t.ms());
+        bench::keep(found);
+    }
+
+}
+
+BENCH(map_string_comparisons) {
+    bench::random rng(31);
+    //a long common prefix, as in file paths or qualified names, makes each comparison costly
+    std::vector<std::string> keys(n);
+    for (size_t i = 0; i < n; ++i) keys[i] = "/srv/data/tables/partition_" + std::to_string(rng.below(1000000000));
+    run<counting_less>("less-than", keys);
+    run<counting_three_way>("three-way", keys);
+}
@@ -0,0 +1,33 @@
+#include "bench.hpp"
+#include "map.hpp"
+#include <vector>
+
+BENCH(map_find_batch) {
+    //10M lookups into a map far larger than the caches, 7 in 8 of them hits
+    const size_t size = 4000000, n = 10000000;
+    typedef sjtu::map<uint64_t, uint64_t> map_type;
+    bench::random rng(35);
+    map_type m;
+    std::vector<uint64_t> present(size), keys(n);
+    for (size_t i = 0; i < size; ++i) {
+        present[i] = rng() & ~1ull;
+        m[present[i]] = i;
+    }
+    for (size_t i = 0; i < n; ++i) keys[i] = (i % 8) ? present[rng.below(size)] : rng() | 1;
+    uint64_t sum = 0;
+    bench::timer t;
+    for (size_t i = 0; i < n; ++i) {
+        map_type::iterator it = m.find(keys[i]);
+        if (it != m.end()) sum += it->second;
+    }
+    bench::report("10M lookups in 4M", "find", t.ms());
+    std::vector<map_type::iterator> out(n);
+    uint64_t batched = 0;
+    t = bench::timer();
+    m.find_batch(keys.data(), n, out.data());
+    for (size_t i = 0; i < n; ++i)
+        if (out[i] != m.end()) batched += out[i]->second;
+    bench::report("10M lookups in 4M", "find_batch", t.ms());
+    bench::expect(sum == batched, "find_batch finds what find finds");
+    bench::keep(sum);
+}
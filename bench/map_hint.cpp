@@ -0,0 +1,86 @@
+#include "bench.hpp"
+#include "map.hpp"
+#include <vector>
+
+namespace {
+
+    class counting_less {
+    public:
+        static size_t calls;
+
+        bool operator()(uint64_t lhs, uint64_t rhs) const {
+            ++calls;
+            return lhs < rhs;
+        }
+    };
+
+    size_t counting_less::calls = 0;
+
+    typedef sjtu::map<uint64_t, uint64_t, counting_less> map_type;
+    typedef sjtu::pair<const uint64_t, uint64_t> value_type;
+
+    const size_t n = 1000000;
+
+    //comparisons per insert and the time of the n inserts
+    class measure {
+    private:
+        const char *row, *column;
+        bench::timer t;
+        size_t before;
+
+    public:
+        measure(const char *row, const char *column) : row(row), column(column), before(counting_less::calls) {}
+
+        ~measure() {
+            double ms = t.ms();
+            bench::report_count(row, column, (double) (counting_less::calls - before) / n, "comparisons per op");
+            bench::report(row, column, ms);
+        }
+    };
+
+}
+
+BENCH(map_hinted_insert) {
+    bench::random rng(39);
+    std::vector<uint64_t> shuffled(n);
+    for (size_t i = 0; i < n; ++i) shuffled[i] = i;
+    for (size_t i = n - 1; i > 0; --i) {
+        size_t j = rng.below(i + 1);
+        uint64_t tmp = shuffled[i];
+        shuffled[i] = shuffled[j];
+        shuffled[j] = tmp;
+    }
+    {
+        map_type m;
+        measure run("increasing keys", "insert");
+        for (size_t i = 0; i < n; ++i) m.insert(value_type(i, i));
+    }
+    {
+        map_type m;
+        measure run("decreasing keys", "insert");
+        for (size_t i = n; i-- > 0;) m.insert(value_type(i, i));
+    }
+    {
+        //each key belongs right before the previous one
+        map_type m;
+        measure run("decreasing keys", "insert(previous, value)");
+        map_type::iterator hint = m.end();
+        for (size_t i = n; i-- > 0;) hint = m.insert(hint, value_type(i, i));
+    }
+    {
+        //keys short of the largest pay one comparison with it before descending,
+        //the largest share of the work in small maps
+        measure run("shuffled keys into maps of 64", "insert");
+        for (size_t i = 0; i < n; i += 64) {
+            map_type m;
+            for (size_t j = i; j < i + 64; ++j) m.insert(value_type(shuffled[j] & 1023, j));
+        }
+    }
+    {
+        //every insert descends from the root, as plain insert did before the append path.
+        //run last, as freeing this map leaves the allocator handing out scattered memory
+        map_type m;
+        measure run("the same keys shuffled", "insert");
+        for (size_t i = 0; i < n; ++i) m.insert(value_type(shuffled[i], i));
+    }
+}
@@ -0,0 +1,78 @@
+#include "bench.hpp"
+#include "multi_queue.hpp"
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+    const size_t prefill = 1000000;
+    const size_t operations = 8000000;
+
+    //what the schedulers do today: one priority_queue behind one mutex
+    class locked_queue {
+    private:
+        std::mutex lock;
+        sjtu::priority_queue<uint64_t, std::less<uint64_t>, sjtu::dary_heap<4>> q;
+
+    public:
+        void push(const uint64_t &e) {
+            std::lock_guard<std::mutex> guard(lock);
+            q.push(e);
+        }
+
+        bool try_pop(uint64_t &res) {
+            std::lock_guard<std::mutex> guard(lock);
+            if (q.empty()) return false;
+            res = q.pop_value();
+            return true;
+        }
+    };
+
+    //alternate push and try_pop, as a scheduler that spawns one task for each it runs
+    template<class Queue>
+    void worker(Queue *q, uint64_t seed, size_t ops, uint64_t *sum) {
+        bench::random rng(seed);
+        uint64_t res = 0, total = 0;
+        for (size_t i = 0; i < ops; ++i) {
+            if (i & 1) {
+                if (q->try_pop(res)) total += res;
+            } else q->push(rng());
+        }
+        *sum = total;
+    }
+
+    template<class Queue>
+    void run(const char *column, Queue &q, size_t threads) {
+        bench::random rng(48);
+        for (size_t i = 0; i < prefill; ++i) q.push(rng());
+        std::vector<std::thread> pool;
+        std::vector<uint64_t> sums(threads);
+        bench::timer t;
+        for (size_t i = 0; i < threads; ++i)
+            pool.push_back(std::thread(worker<Queue>, &q, i + 1, operations / threads, &sums[i]));
+        for (size_t i = 0; i < threads; ++i) pool[i].join();
+        double ms = t.ms();
+        std::string row = std::to_string(threads) + " threads, Mops/s";
+        bench::report_count(row.c_str(), column, operations / ms / 1000, "");
+        for (size_t i = 0; i < threads; ++i) bench::keep(sums[i]);
+    }
+
+}
+
+BENCH(multi_queue_scaling) {
+    for (size_t threads = 1; threads <= 8; threads *= 2) {
+        {
+            locked_queue q;
+            run("locked priority_queue", q, threads);
+        }
+        sjtu::multi_queue<uint64_t> q(threads, 2);
+        q.sample_rank_error(1000);
+        run("multi_queue", q, threads);
+        sjtu::multi_queue_stats s = q.stats();
+        std::string row = std::to_string(threads) + " threads, rank error";
+        bench::report_count(row.c_str(), "multi_queue mean", s.mean_rank_error, "");
+        bench::report_count(row.c_str(), "multi_queue max", (double) s.max_rank_error, "");
+    }
+}
@@ -0,0 +1,57 @@
+#include "bench.hpp"
+#include "persistent_map.hpp"
+#include "map.hpp"
+#include <vector>
+
+namespace {
+
+    typedef sjtu::pair<const uint64_t, uint64_t> value_type;
+
+}
+
+BENCH(persistent_map_snapshots) {
+    const size_t n = 1000000, updates = 100000;
+    bench::random rng(32);
+    std::vector<uint64_t> keys(n);
+    for (size_t i = 0; i < n; ++i) keys[i] = rng() & ~1ull;
+    sjtu::persistent_map<uint64_t, uint64_t> p;
+    sjtu::map<uint64_t, uint64_t> m;
+    for (size_t i = 0; i < n; ++i) {
+        p = p.insert(value_type(keys[i], i));
+        m[keys[i]] = i;
+    }
+    {
+        const size_t rounds = 1000000;
+        bench::timer t;
+        for (size_t r = 0; r < rounds; ++r) {
+            sjtu::persistent_map<uint64_t, uint64_t> snapshot(p);
+            bench::keep(snapshot.size());
+        }
+        bench::report_count("snapshot of 1M, per copy", "persistent_map", t.ms() * 1e6 / rounds, "ns");
+    }
+    {
+        const size_t rounds = 5;
+        bench::timer t;
+        for (size_t r = 0; r < rounds; ++r) {
+            sjtu::map<uint64_t, uint64_t> snapshot(m);
+            bench::keep(snapshot.size());
+        }
+        bench::report("snapshot of 1M, per copy", "map", t.ms() / rounds);
+    }
+    //every update makes a new version while the old ones stay alive as snapshots
+    std::vector<sjtu::persistent_map<uint64_t, uint64_t>> versions;
+    versions.reserve(updates * 2 + 1);
+    versions.push_back(p);
+    size_t before = bench::allocations();
+    bench::timer t;
+    for (size_t i = 0; i < updates; ++i) versions.push_back(versions.back().insert(value_type(rng() | 1, i)));
+    bench::report("100K inserts into 1M", "persistent_map", t.ms());
+    bench::report_count("100K inserts into 1M", "allocations", (double) (bench::allocations() - before) / updates,
+                        "per op");
+    before = bench::allocations();
+    t = bench::timer();
+    for (size_t i = 0; i < updates; ++i) versions.push_back(versions.back().erase(keys[i]));
+    bench::report("100K erases from 1.1M", "persistent_map", t.ms());
+    bench::report_count("100K erases from 1.1M", "allocations", (double) (bench::allocations() - before) / updates,
+                        "per op");
+}
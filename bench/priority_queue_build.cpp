@@ -0,0 +1,71 @@
+#include "bench.hpp"
+#include "priority_queue.hpp"
+#include <string>
+#include <vector>
+
+namespace {
+
+    enum build_method {
+        by_push, by_range, by_assign
+    };
+
+    class workload {
+    public:
+        size_t n;
+        bool ascending;
+        build_method method;
+    };
+
+    //the time to fill a queue with n elements and pop its top once
+    template<class Heap>
+    double run(const workload &w) {
+        std::vector<uint64_t> values(w.n);
+        bench::random rng(45);
+        for (size_t i = 0; i < w.n; ++i) values[i] = w.ascending ? i : rng();
+        typedef sjtu::priority_queue<uint64_t, std::less<uint64_t>, Heap> queue;
+        uint64_t sum = 0;
+        bench::timer t;
+        if (w.method == by_push) {
+            queue q;
+            for (size_t i = 0; i < w.n; ++i) q.push(values[i]);
+            sum += q.top();
+            q.pop();
+            sum += q.top();
+        } else if (w.method == by_range) {
+            queue q(values.begin(), values.end());
+            sum += q.top();
+            q.pop();
+            sum += q.top();
+        } else {
+            queue q;
+            q.push(0);
+            q.assign(values.begin(), values.end());
+            sum += q.top();
+            q.pop();
+            sum += q.top();
+        }
+        double ms = t.ms();
+        bench::keep(sum);
+        return ms;
+    }
+
+    template<class Heap>
+    void report(const workload &w, const std::string &row, const char *column) {
+        bench::report(row.c_str(), column, bench::isolated(run<Heap>, w));
+    }
+
+}
+
+BENCH(priority_queue_build) {
+    const char *methods[] = {"push", "range constructor", "assign"};
+    for (int ascending = 0; ascending < 2; ++ascending)
+        for (size_t n = 1000000; n <= 4000000; n *= 4)
+            for (int m = by_push; m <= by_assign; ++m) {
+                workload w = {n, ascending != 0, (build_method) m};
+                std::string row = std::to_string(n / 1000000) + "M " + (ascending ? "ascending" : "random") + ", " + methods[m];
+                report<sjtu::binomial_heap>(w, row, "binomial_heap");
+                report<sjtu::lazy_binomial_heap>(w, row, "lazy_binomial_heap");
+                report<sjtu::pairing_heap>(w, row, "pairing_heap");
+                report<sjtu::dary_heap<4>>(w, row, "dary_heap<4>");
+            }
+}
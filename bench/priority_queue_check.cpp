@@ -0,0 +1,279 @@
+#include "bench.hpp"
+#include "priority_queue.hpp"
+#include <set>
+#include <vector>
+
+namespace {
+
+    typedef sjtu::priority_queue<int, std::less<int>, sjtu::pairing_heap> pairing;
+
+    //the elements of the queue with their handles, to find the top by brute force
+    class reference {
+    public:
+        std::vector<int> values;
+        std::vector<pairing::handle> handles;
+
+        size_t best() const {
+            size_t res = 0;
+            for (size_t i = 1; i < values.size(); ++i)
+                if (values[res] < values[i]) res = i;
+            return res;
+        }
+
+        void remove(size_t i) {
+            values[i] = values.back(), handles[i] = handles.back();
+            values.pop_back(), handles.pop_back();
+        }
+    };
+
+    class counting_less {
+    public:
+        static size_t calls;
+
+        bool operator()(long lhs, long rhs) const {
+            ++calls;
+            return lhs < rhs;
+        }
+    };
+
+    size_t counting_less::calls = 0;
+
+    //an element that counts how often it is copied
+    class counted {
+    public:
+        static size_t copies;
+        long key;
+
+        counted(long key = 0) : key(key) {}
+
+        counted(const counted &other) : key(other.key) { ++copies; }
+
+        counted(counted &&other) noexcept : key(other.key) {}
+
+        counted &operator=(const counted &other) {
+            key = other.key;
+            ++copies;
+            return *this;
+        }
+
+        counted &operator=(counted &&other) noexcept {
+            key = other.key;
+            return *this;
+        }
+
+        bool operator<(const counted &other) const { return key < other.key; }
+    };
+
+    size_t counted::copies = 0;
+
+    //push(T&&), emplace, pop_value and moving the queue must never copy an element
+    template<class Heap>
+    void check_no_copies() {
+        typedef sjtu::priority_queue<counted, std::less<counted>, Heap> queue;
+        bench::random rng(46);
+        std::vector<long> keys;
+        counted::copies = 0;
+        queue q;
+        for (size_t i = 0; i < 20000; ++i) {
+            long e = (long) rng.below(1000000);
+            keys.push_back(e);
+            if (i & 1) q.push(counted(e));
+            else q.emplace(e);
+            if (i % 3 == 0) {
+                std::vector<long>::iterator best = keys.begin();
+                for (std::vector<long>::iterator it = keys.begin(); it != keys.end(); ++it)
+                    if (*best < *it) best = it;
+                bench::expect(q.pop_value().key == *best, "pop_value returns the top");
+                *best = keys.back();
+                keys.pop_back();
+            }
+        }
+        queue moved(std::move(q)), assigned;
+        assigned.push(counted(1));
+        assigned = std::move(moved);
+        bench::expect(assigned.size() == keys.size(), "a moved queue keeps its elements");
+        while (!assigned.empty()) assigned.pop_value();
+        bench::expect(counted::copies == 0, "push(T&&), emplace, pop_value and moves copy no element");
+        queue source;
+        for (size_t i = 0; i < 1000; ++i) source.push(counted((long) i));
+        counted::copies = 0;
+        queue copy(source);
+        bench::expect(counted::copies == 1000 && copy.size() == 1000, "a copied queue copies each element once");
+    }
+
+    //merge must add the sizes, empty other and keep every element, whatever the two sizes
+    template<class Heap>
+    void check_merge() {
+        typedef sjtu::priority_queue<long, std::less<long>, Heap> queue;
+        bench::random rng(41);
+        const size_t sizes[][2] = {{0, 0}, {0, 7}, {7, 0}, {1, 1}, {100, 3}, {3, 100}, {1000, 1000}, {4096, 4095}};
+        for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+            queue q, other;
+            std::multiset<long> ref;
+            for (size_t i = 0; i < sizes[s][0]; ++i) {
+                long e = (long) rng.below(1000);
+                q.push(e), ref.insert(e);
+            }
+            for (size_t i = 0; i < sizes[s][1]; ++i) {
+                long e = (long) rng.below(1000);
+                other.push(e), ref.insert(e);
+            }
+            //some pops first, so that the trees are not only those built by pushes
+            for (size_t i = 0; i < sizes[s][1] / 2; ++i) ref.erase(ref.find(other.pop_value()));
+            q.merge(other);
+            bench::expect(q.size() == ref.size(), "size is the sum of the sizes after merge");
+            bench::expect(other.empty() && other.size() == 0, "merge empties other");
+            q.merge(q);
+            bench::expect(q.size() == ref.size(), "merging a queue into itself changes nothing");
+            other.push(-1), ref.insert(-1);
+            q.merge(other);
+            bench::expect(q.size() == ref.size() && other.empty(), "other can be merged again after merge");
+            while (!q.empty()) {
+                bench::expect(q.size() == ref.size(), "size follows the pops after merge");
+                bench::expect(q.pop_value() == *ref.rbegin(), "pop returns the greatest element after merge");
+                ref.erase(--ref.end());
+            }
+            bench::expect(ref.empty(), "merge keeps every element");
+        }
+    }
+
+}
+
+CHECK(pairing_heap_handles) {
+    bench::random rng(431);
+    pairing q;
+    reference ref;
+    for (size_t step = 0; step < 200000; ++step) {
+        size_t op = rng.below(8);
+        int e = (int) rng.below(100000);
+        if (op < 3 || ref.values.empty()) {
+            ref.handles.push_back(q.push(e));
+            ref.values.push_back(e);
+        } else if (op == 3) {
+            size_t i = ref.best();
+            bench::expect(q.top() == ref.values[i], "top is the greatest element");
+            bench::expect(q.pop_value() == ref.values[i], "pop_value returns the top");
+            ref.remove(i);
+        } else if (op == 4) {
+            size_t i = rng.below(ref.values.size());
+            q.modify(ref.handles[i], e);
+            ref.values[i] = e;
+        } else if (op == 5) {
+            size_t i = rng.below(ref.values.size());
+            if (e < ref.values[i]) {
+                bool thrown = false;
+                try {
+                    q.decrease_key(ref.handles[i], e);
+                } catch (sjtu::runtime_error &) {
+                    thrown = true;
+                }
+                bench::expect(thrown, "decrease_key away from the top throws runtime_error");
+            } else {
+                q.decrease_key(ref.handles[i], e);
+                ref.values[i] = e;
+            }
+        } else if (op == 6) {
+            size_t i = rng.below(ref.values.size());
+            q.erase(ref.handles[i]);
+            ref.remove(i);
+        } else {
+            size_t i = rng.below(ref.values.size());
+            bench::expect(q.value(ref.handles[i]) == ref.values[i], "a handle reads its element");
+        }
+        bench::expect(q.size() == ref.values.size(), "size follows the operations");
+        if (!ref.values.empty()) bench::expect(q.top() == ref.values[ref.best()], "top is the greatest element");
+    }
+    bool thrown = false;
+    try {
+        q.erase(pairing::handle());
+    } catch (sjtu::invalid_iterator &) {
+        thrown = true;
+    }
+    bench::expect(thrown, "a null handle throws invalid_iterator");
+}
+
+//binomial_heap once left a tree of the size of the first root unlinked, so the root list grew
+//to O(n) trees and every pop scanned them all. an event loop, where each element popped pushes
+//a few slightly lower ones as in Dijkstra, hit it at once. pops must stay O(log n) comparisons
+CHECK(binomial_heap_root_list) {
+    bench::random rng(432);
+    sjtu::priority_queue<long, counting_less> q;
+    std::multiset<long> ref;
+    size_t ops = 1;
+    counting_less::calls = 0;
+    q.push(0);
+    ref.insert(0);
+    for (size_t i = 0; i < 60000 && !q.empty(); ++i) {
+        long top = q.top();
+        bench::expect(top == *ref.rbegin(), "top is the greatest element");
+        q.pop();
+        ref.erase(--ref.end());
+        size_t k = rng.below(4) + (q.size() < 1000);
+        for (size_t j = 0; j < k; ++j) {
+            long e = top - (long) rng.below(1000) - 1;
+            q.push(e);
+            ref.insert(e);
+        }
+        ops += k + 1;
+    }
+    bench::expect(q.size() == ref.size(), "size follows the operations");
+    //under 8 per operation when the roots are linked, over 1000 with the old bug
+    bench::expect(counting_less::calls < ops * 40, "push and pop take O(log n) comparisons");
+}
+
+//binomial_heap::merge once left size() at the size before the merge
+//pop hands the children of the top root to _insert, whose first one once skipped the carry
+//when the front root had its size, so two trees of one size stayed in the root list and
+//further pops and pushes piled up more. with the carries every size appears once, so a pop
+//compares at most about twice per bit of size()
+CHECK(binomial_heap_carry) {
+    sjtu::priority_queue<long, counting_less> q;
+    std::multiset<long> ref;
+    for (long n = 1; n <= 300; ++n) {
+        //decreasing keys put the top in the largest tree, whose children meet every smaller root
+        for (long i = n; i > 0; --i) q.push(i * 1000 + n), ref.insert(i * 1000 + n);
+        for (long i = 0; i < n / 2; ++i) {
+            size_t bits = 0;
+            for (size_t s = q.size(); s; s >>= 1) ++bits;
+            counting_less::calls = 0;
+            q.pop();
+            ref.erase(--ref.end());
+            bench::expect(counting_less::calls <= 2 * bits + 2, "a pop compares O(log n) times");
+            bench::expect(q.top() == *ref.rbegin(), "top is the greatest element");
+            q.push(-i), ref.insert(-i);
+        }
+        bench::expect(q.size() == ref.size(), "size follows the operations");
+    }
+    while (!q.empty()) {
+        bench::expect(q.pop_value() == *ref.rbegin(), "pop returns the greatest element");
+        ref.erase(--ref.end());
+    }
+}
+
+CHECK(priority_queue_merge) {
+    check_merge<sjtu::binomial_heap>();
+    check_merge<sjtu::lazy_binomial_heap>();
+    check_merge<sjtu::pairing_heap>();
+    check_merge<sjtu::dary_heap<4>>();
+}
+
+//dary_heap::merge once grew the buffer to exactly the combined size, so merging queue after
+//queue into one reallocated and moved every element on each merge. it has to grow geometrically
+CHECK(dary_heap_merge_growth) {
+    typedef sjtu::priority_queue<long, std::less<long>, sjtu::dary_heap<4>> queue;
+    const size_t n = 20000;
+    std::vector<queue> parts(n);
+    for (size_t i = 0; i < n; ++i) parts[i].push((long) i);
+    queue q;
+    size_t before = bench::allocations();
+    for (size_t i = 0; i < n; ++i) q.merge(parts[i]);
+    bench::expect(bench::allocations() - before < 64, "merges reallocate O(log n) times");
+    bench::expect(q.size() == n && q.top() == (long) n - 1, "merges keep every element");
+}
+
+CHECK(priority_queue_copies) {
+    check_no_copies<sjtu::binomial_heap>();
+    check_no_copies<sjtu::lazy_binomial_heap>();
+    check_no_copies<sjtu::pairing_heap>();
+    check_no_copies<sjtu::dary_heap<4>>();
+}
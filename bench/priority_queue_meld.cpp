@@ -0,0 +1,58 @@
+#include "bench.hpp"
+#include "priority_queue.hpp"
+#include <string>
+
+namespace {
+
+    //small queues are built and melded into one accumulator, which pops drain times every period melds
+    class workload {
+    public:
+        size_t queues, each, period, drain;
+        const char *row;
+    };
+
+    template<class Heap>
+    double run(const workload &w) {
+        bench::random rng(44);
+        uint64_t sum = 0;
+        sjtu::priority_queue<uint64_t, std::less<uint64_t>, Heap> acc;
+        bench::timer t;
+        for (size_t b = 1; b <= w.queues; ++b) {
+            sjtu::priority_queue<uint64_t, std::less<uint64_t>, Heap> q;
+            for (size_t i = 0; i < w.each; ++i) q.push(rng());
+            acc.merge(q);
+            if (b % w.period == 0)
+                for (size_t i = 0; i < w.drain && !acc.empty(); ++i) {
+                    sum += acc.top();
+                    acc.pop();
+                }
+        }
+        double ms = t.ms();
+        bench::keep(sum);
+        return ms;
+    }
+
+    template<class Heap>
+    void report(const workload &w, const char *column) {
+        bench::report(w.row, column, bench::isolated(run<Heap>, w));
+    }
+
+}
+
+BENCH(priority_queue_meld) {
+    const size_t never = (size_t) -1;
+    const workload workloads[] = {
+            {1000000, 4, 1, 2, "1M melds of 4, 2 pops per meld"},
+            {1000000, 4, 1000, 100, "1M melds of 4, 100 pops per 1000"},
+            {1000000, 4, never, 0, "1M melds of 4, no pops"},
+            {250000, 16, 1, 8, "250K melds of 16, 8 pops per meld"},
+            {250000, 16, 1000, 100, "250K melds of 16, 100 pops per 1000"},
+            {250000, 16, never, 0, "250K melds of 16, no pops"},
+    };
+    for (size_t i = 0; i < sizeof(workloads) / sizeof(workload); ++i) {
+        report<sjtu::binomial_heap>(workloads[i], "binomial_heap");
+        report<sjtu::lazy_binomial_heap>(workloads[i], "lazy_binomial_heap");
+        report<sjtu::pairing_heap>(workloads[i], "pairing_heap");
+        report<sjtu::dary_heap<4>>(workloads[i], "dary_heap<4>");
+    }
+}
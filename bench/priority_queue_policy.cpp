@@ -0,0 +1,49 @@
+#include "bench.hpp"
+#include "priority_queue.hpp"
+#include <string>
+#include <vector>
+
+namespace {
+
+    //fill a queue with n random ints and drain it, rounds times, and report ns per push and per pop
+    template<class Heap>
+    void run(const char *column, const std::vector<uint64_t> &data, size_t n) {
+        size_t rounds = n < 1000000 ? 1000000 / n : 1;
+        double pushMs = 0, popMs = 0;
+        uint64_t sum = 0;
+        {
+            //an untimed fill first, so that no policy pays for the page faults of fresh memory
+            sjtu::priority_queue<uint64_t, std::less<uint64_t>, Heap> q;
+            for (size_t i = 0; i < n; ++i) q.push(data[i]);
+        }
+        for (size_t r = 0; r < rounds; ++r) {
+            sjtu::priority_queue<uint64_t, std::less<uint64_t>, Heap> q;
+            bench::timer t;
+            for (size_t i = 0; i < n; ++i) q.push(data[i]);
+            pushMs += t.ms();
+            t = bench::timer();
+            while (!q.empty()) {
+                sum += q.top();
+                q.pop();
+            }
+            popMs += t.ms();
+        }
+        std::string push = "n = " + std::to_string(n) + ", ns per push", pop = "n = " + std::to_string(n) + ", ns per pop";
+        bench::report_count(push.c_str(), column, pushMs * 1e6 / (rounds * n), "");
+        bench::report_count(pop.c_str(), column, popMs * 1e6 / (rounds * n), "");
+        bench::keep(sum);
+    }
+
+}
+
+BENCH(priority_queue_policies) {
+    const size_t most = 10000000;
+    bench::random rng(42);
+    std::vector<uint64_t> data(most);
+    for (size_t i = 0; i < most; ++i) data[i] = rng();
+    for (size_t n = 1000; n <= most; n *= 10) {
+        run<sjtu::binomial_heap>("binomial_heap", data, n);
+        run<sjtu::dary_heap<4>>("dary_heap<4>", data, n);
+        run<sjtu::dary_heap<8>>("dary_heap<8>", data, n);
+    }
+}
@@ -0,0 +1,64 @@
+#include "bench.hpp"
+#include "priority_queue.hpp"
+#include <string>
+#include <vector>
+
+namespace {
+
+    //a string of about 60 characters that counts its copies, so that a copy is costly and visible
+    class heavy {
+    public:
+        static size_t copies;
+        std::string text;
+
+        explicit heavy(const std::string &text) : text(text) {}
+
+        heavy(const heavy &other) : text(other.text) {
+            ++copies;
+        }
+
+        heavy(heavy &&other) = default;
+
+        heavy &operator=(const heavy &other) {
+            text = other.text;
+            ++copies;
+            return *this;
+        }
+
+        heavy &operator=(heavy &&other) = default;
+
+        bool operator<(const heavy &rhs) const {
+            return text < rhs.text;
+        }
+    };
+
+    size_t heavy::copies = 0;
+
+}
+
+BENCH(priority_queue_top_and_pop) {
+    const size_t n = 200000, tops = 10000000;
+    bench::random rng(41);
+    sjtu::priority_queue<heavy> q;
+    for (size_t i = 0; i < n; ++i) q.push(heavy(std::string(48, 'a') + std::to_string(rng())));
+    uint64_t sum = 0;
+    bench::timer t;
+    for (size_t i = 0; i < tops; ++i) sum += q.top().text.size();
+    bench::report("10M top() on 200K", "binomial_heap", t.ms());
+    //a scheduler loop: look at the top, take it and push a later one
+    size_t before = heavy::copies;
+    t = bench::timer();
+    for (size_t i = 0; i < n; ++i) {
+        sum += q.top().text.size();
+        q.pop();
+        q.push(heavy(std::string(48, 'a') + std::to_string(rng())));
+    }
+    bench::report("200K top(), pop(), push()", "binomial_heap", t.ms());
+    bench::report_count("200K top(), pop(), push()", "copies of T", (double) (heavy::copies - before), "");
+    before = heavy::copies;
+    t = bench::timer();
+    while (!q.empty()) q.pop();
+    bench::report("drain 200K with pop()", "binomial_heap", t.ms());
+    bench::report_count("drain 200K with pop()", "copies of T", (double) (heavy::copies - before), "");
+    bench::keep(sum);
+}
@@ -0,0 +1,84 @@
+#include "bench.hpp"
+#include "graph.hpp"
+#include "priority_queue.hpp"
+#include "radix_heap.hpp"
+#include <string>
+#include <vector>
+
+namespace {
+
+    //a tentative distance, the least distance ranks highest
+    class item {
+    public:
+        uint64_t dist;
+        uint32_t vertex;
+
+        item(uint64_t dist, uint32_t vertex) : dist(dist), vertex(vertex) {}
+
+        bool operator<(const item &rhs) const {
+            return dist > rhs.dist;
+        }
+    };
+
+    template<class Heap>
+    uint64_t with_queue(const bench::graph &g) {
+        std::vector<uint64_t> dist(g.vertices, UINT64_MAX);
+        sjtu::priority_queue<item, std::less<item>, Heap> q;
+        dist[0] = 0;
+        q.push(item(0, 0));
+        while (!q.empty()) {
+            item top = q.top();
+            q.pop();
+            if (top.dist != dist[top.vertex]) continue;
+            for (size_t e = g.start[top.vertex]; e < g.start[top.vertex + 1]; ++e) {
+                uint64_t d = top.dist + g.weight[e];
+                if (d < dist[g.to[e]]) {
+                    dist[g.to[e]] = d;
+                    q.push(item(d, g.to[e]));
+                }
+            }
+        }
+        return bench::distance_sum(dist);
+    }
+
+    //the same search with distances as radix_heap keys, which never fall below the last popped
+    uint64_t with_radix_heap(const bench::graph &g) {
+        std::vector<uint64_t> dist(g.vertices, UINT64_MAX);
+        sjtu::radix_heap<uint64_t, uint32_t> q;
+        dist[0] = 0;
+        q.push(0, 0);
+        while (!q.empty()) {
+            uint64_t d = q.top().first;
+            uint32_t v = q.top().second;
+            q.pop();
+            if (d != dist[v]) continue;
+            for (size_t e = g.start[v]; e < g.start[v + 1]; ++e) {
+                uint64_t next = d + g.weight[e];
+                if (next < dist[g.to[e]]) {
+                    dist[g.to[e]] = next;
+                    q.push(next, g.to[e]);
+                }
+            }
+        }
+        return bench::distance_sum(dist);
+    }
+
+}
+
+BENCH(radix_heap_road_grid) {
+    const size_t sides[] = {300, 1000, 2000};
+    for (size_t i = 0; i < sizeof(sides) / sizeof(size_t); ++i) {
+        bench::graph g = bench::graph::grid(sides[i], 49);
+        std::string row = std::to_string(sides[i]) + " x " + std::to_string(sides[i]) + " grid";
+        bench::timer t;
+        uint64_t expected = with_queue<sjtu::binomial_heap>(g);
+        bench::report(row.c_str(), "binomial_heap", t.ms());
+        t = bench::timer();
+        uint64_t dary = with_queue<sjtu::dary_heap<4>>(g);
+        bench::report(row.c_str(), "dary_heap<4>", t.ms());
+        t = bench::timer();
+        uint64_t radix = with_radix_heap(g);
+        bench::report(row.c_str(), "radix_heap", t.ms());
+        bench::expect(dary == expected && radix == expected, "every queue finds the same distances");
+    }
+}
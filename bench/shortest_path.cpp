@@ -0,0 +1,90 @@
+#include "bench.hpp"
+#include "graph.hpp"
+#include "priority_queue.hpp"
+#include <string>
+#include <vector>
+
+namespace {
+
+    //a tentative distance, the least distance ranks highest
+    class item {
+    public:
+        uint64_t dist;
+        uint32_t vertex;
+
+        item(uint64_t dist, uint32_t vertex) : dist(dist), vertex(vertex) {}
+
+        bool operator<(const item &rhs) const {
+            return dist > rhs.dist;
+        }
+    };
+
+    //the workaround without decrease_key: push again on every improvement and skip stale entries
+    template<class Heap>
+    uint64_t lazy_deletion(const bench::graph &g) {
+        std::vector<uint64_t> dist(g.vertices, UINT64_MAX);
+        sjtu::priority_queue<item, std::less<item>, Heap> q;
+        dist[0] = 0;
+        q.push(item(0, 0));
+        while (!q.empty()) {
+            item top = q.top();
+            q.pop();
+            if (top.dist != dist[top.vertex]) continue;
+            for (size_t e = g.start[top.vertex]; e < g.start[top.vertex + 1]; ++e) {
+                uint64_t d = top.dist + g.weight[e];
+                if (d < dist[g.to[e]]) {
+                    dist[g.to[e]] = d;
+                    q.push(item(d, g.to[e]));
+                }
+            }
+        }
+        return bench::distance_sum(dist);
+    }
+
+    //one entry per vertex, moved toward the top by its handle
+    uint64_t with_decrease_key(const bench::graph &g) {
+        typedef sjtu::priority_queue<item, std::less<item>, sjtu::pairing_heap> queue;
+        std::vector<uint64_t> dist(g.vertices, UINT64_MAX);
+        std::vector<queue::handle> handles(g.vertices);
+        std::vector<char> done(g.vertices, 0);
+        queue q;
+        dist[0] = 0;
+        handles[0] = q.push(item(0, 0));
+        while (!q.empty()) {
+            item top = q.pop_value();
+            done[top.vertex] = 1;
+            for (size_t e = g.start[top.vertex]; e < g.start[top.vertex + 1]; ++e) {
+                uint32_t v = g.to[e];
+                uint64_t d = top.dist + g.weight[e];
+                if (done[v] || d >= dist[v]) continue;
+                if (dist[v] == UINT64_MAX) handles[v] = q.push(item(d, v));
+                else q.decrease_key(handles[v], item(d, v));
+                dist[v] = d;
+            }
+        }
+        return bench::distance_sum(dist);
+    }
+
+}
+
+BENCH(shortest_path_decrease_key) {
+    const size_t sizes[][2] = {{100000, 1000000}, {1000000, 10000000}};
+    for (size_t i = 0; i < 2; ++i) {
+        bench::graph g = bench::graph::random_graph(sizes[i][0], sizes[i][1], 43);
+        std::string row = "V = " + std::to_string(sizes[i][0]) + ", E = " + std::to_string(sizes[i][1]);
+        bench::timer t;
+        uint64_t expected = lazy_deletion<sjtu::binomial_heap>(g);
+        bench::report(row.c_str(), "lazy binomial_heap", t.ms());
+        t = bench::timer();
+        uint64_t dary = lazy_deletion<sjtu::dary_heap<4>>(g);
+        bench::report(row.c_str(), "lazy dary_heap<4>", t.ms());
+        t = bench::timer();
+        uint64_t pairing = lazy_deletion<sjtu::pairing_heap>(g);
+        bench::report(row.c_str(), "lazy pairing_heap", t.ms());
+        t = bench::timer();
+        uint64_t handles = with_decrease_key(g);
+        bench::report(row.c_str(), "pairing_heap decrease_key", t.ms());
+        bench::expect(dary == expected && pairing == expected && handles == expected,
+                      "every queue finds the same distances");
+    }
+}
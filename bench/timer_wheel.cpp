@@ -0,0 +1,135 @@
+#include "bench.hpp"
+#include "priority_queue.hpp"
+#include "timer_wheel.hpp"
+#include <vector>
+
+namespace {
+
+    //every tick schedules rate timers due timeout to timeout + 999 ticks later, and 95% of them
+    //are cancelled 1 to 1000 ticks after they were scheduled
+    const size_t ticks = 1000, rate = 10000, timeout = 30000, horizon = 1024;
+
+    class ignore {
+    public:
+        void operator()(uint32_t &) const {}
+    };
+
+    class wheel_timers {
+    private:
+        sjtu::timer_wheel<uint32_t> wheel;
+
+    public:
+        typedef sjtu::timer_wheel<uint32_t>::handle handle;
+
+        handle schedule(uint64_t deadline, uint32_t id) {
+            return wheel.schedule(deadline, id);
+        }
+
+        void cancel(const handle &h) {
+            wheel.cancel(h);
+        }
+
+        size_t advance(uint64_t now) {
+            return wheel.advance(now, ignore());
+        }
+    };
+
+    class timer {
+    public:
+        uint64_t deadline;
+        uint32_t id;
+
+        timer(uint64_t deadline, uint32_t id) : deadline(deadline), id(id) {}
+
+        bool operator<(const timer &rhs) const {
+            return deadline > rhs.deadline;
+        }
+    };
+
+    //cancel erases the timer by its handle
+    class pairing_timers {
+    private:
+        typedef sjtu::priority_queue<timer, std::less<timer>, sjtu::pairing_heap> queue;
+        queue q;
+
+    public:
+        typedef queue::handle handle;
+
+        handle schedule(uint64_t deadline, uint32_t id) {
+            return q.push(timer(deadline, id));
+        }
+
+        void cancel(const handle &h) {
+            q.erase(h);
+        }
+
+        size_t advance(uint64_t now) {
+            size_t fired = 0;
+            for (; !q.empty() && q.top().deadline <= now; ++fired) q.pop();
+            return fired;
+        }
+    };
+
+    //what the callers do today: cancel flags the timer, which stays in the queue until it is due
+    class flagged_timers {
+    private:
+        sjtu::priority_queue<timer> q;
+        std::vector<char> cancelled;
+
+    public:
+        typedef uint32_t handle;
+
+        flagged_timers() : cancelled(ticks * rate, 0) {}
+
+        handle schedule(uint64_t deadline, uint32_t id) {
+            q.push(timer(deadline, id));
+            return id;
+        }
+
+        void cancel(const handle &h) {
+            cancelled[h] = 1;
+        }
+
+        size_t advance(uint64_t now) {
+            size_t fired = 0;
+            while (!q.empty() && q.top().deadline <= now) {
+                if (!cancelled[q.top().id]) ++fired;
+                q.pop();
+            }
+            return fired;
+        }
+    };
+
+    template<class Timers>
+    double run() {
+        bench::random rng(50);
+        Timers timers;
+        //the handles to cancel at each tick, modulo horizon
+        std::vector<std::vector<typename Timers::handle>> plan(horizon);
+        uint32_t id = 0;
+        size_t fired = 0;
+        bench::timer t;
+        for (uint64_t now = 1; now <= ticks + 1000; ++now) {
+            for (size_t i = 0; now <= ticks && i < rate; ++i, ++id) {
+                typename Timers::handle h = timers.schedule(now + timeout + rng.below(1000), id);
+                if (rng.below(100) < 95) plan[(now + 1 + rng.below(1000)) % horizon].push_back(h);
+            }
+            std::vector<typename Timers::handle> &due = plan[now % horizon];
+            for (size_t i = 0; i < due.size(); ++i) timers.cancel(due[i]);
+            due.clear();
+            fired += timers.advance(now);
+        }
+        fired += timers.advance(ticks + timeout + 1000);
+        double ms = t.ms();
+        bench::keep(fired);
+        return ms;
+    }
+
+}
+
+BENCH(timer_wheel_cancel_heavy) {
+    const char *row = "10M timers, 95% cancelled";
+    bench::report(row, "timer_wheel", bench::isolated(run<wheel_timers>));
+    bench::report(row, "pairing_heap erase", bench::isolated(run<pairing_timers>));
+    bench::report(row, "binomial_heap cancel flags", bench::isolated(run<flagged_timers>));
+}
@@ -0,0 +1,46 @@
+#include "bench.hpp"
+#include "priority_queue.hpp"
+#include "top_k.hpp"
+#include <string>
+
+namespace {
+
+    const size_t items = 20000000;
+
+    //keep the greatest k of a stream of random scores, in millions of items per second
+    double run_top_k(size_t k) {
+        bench::random rng(47);
+        sjtu::top_k<uint32_t> best(k);
+        bench::timer t;
+        for (size_t i = 0; i < items; ++i) best.push((uint32_t) rng());
+        double ms = t.ms();
+        bench::keep(best.threshold());
+        return items / ms / 1000;
+    }
+
+    //what the ranking service does today: a min-queue that pops whenever it holds more than k
+    template<class Heap>
+    double run_queue(size_t k) {
+        bench::random rng(47);
+        sjtu::priority_queue<uint32_t, std::greater<uint32_t>, Heap> best;
+        bench::timer t;
+        for (size_t i = 0; i < items; ++i) {
+            best.push((uint32_t) rng());
+            if (best.size() > k) best.pop();
+        }
+        double ms = t.ms();
+        bench::keep(best.top());
+        return items / ms / 1000;
+    }
+
+}
+
+BENCH(top_k_stream) {
+    const size_t ks[] = {100, 10000, 1000000};
+    for (size_t i = 0; i < sizeof(ks) / sizeof(size_t); ++i) {
+        std::string row = "K = " + std::to_string(ks[i]) + ", M items/s";
+        bench::report_count(row.c_str(), "top_k", bench::isolated(run_top_k, ks[i]), "");
+        bench::report_count(row.c_str(), "dary_heap<4>", bench::isolated(run_queue<sjtu::dary_heap<4>>, ks[i]), "");
+        bench::report_count(row.c_str(), "binomial_heap", bench::isolated(run_queue<sjtu::binomial_heap>, ks[i]), "");
+    }
+}
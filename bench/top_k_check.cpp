@@ -0,0 +1,101 @@
+#include "bench.hpp"
+#include "top_k.hpp"
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+    //an element that counts its instances and throws on the copy that brings countdown to 0
+    class fragile {
+    public:
+        static long live, countdown;
+        long value;
+
+        fragile(long value = 0) : value(value) { ++live; }
+
+        fragile(const fragile &other) : value(other.value) {
+            if (countdown > 0 && --countdown == 0) throw std::runtime_error("copy");
+            ++live;
+        }
+
+        fragile(fragile &&other) noexcept : value(other.value) { ++live; }
+
+        fragile &operator=(const fragile &other) = default;
+
+        fragile &operator=(fragile &&other) noexcept = default;
+
+        ~fragile() { --live; }
+
+        bool operator<(const fragile &rhs) const { return value < rhs.value; }
+    };
+
+    long fragile::live = 0, fragile::countdown = 0;
+
+    std::vector<long> values(const sjtu::top_k<fragile> &best) {
+        std::vector<fragile> kept;
+        best.sorted(std::back_inserter(kept));
+        std::vector<long> res;
+        for (size_t i = 0; i < kept.size(); ++i) res.push_back(kept[i].value);
+        return res;
+    }
+
+}
+
+CHECK(top_k_greatest) {
+    bench::random rng(47);
+    const size_t ks[] = {0, 1, 5, 100};
+    for (size_t i = 0; i < sizeof(ks) / sizeof(ks[0]); ++i) {
+        sjtu::top_k<long> best(ks[i]);
+        std::vector<long> all, kept;
+        for (size_t j = 0; j < 5000; ++j) {
+            long e = (long) rng.below(3000);
+            best.push(e);
+            all.push_back(e);
+        }
+        std::sort(all.begin(), all.end(), std::greater<long>());
+        all.resize(std::min(all.size(), ks[i]));
+        best.take_sorted(std::back_inserter(kept));
+        bench::expect(kept == all, "top_k keeps the K greatest elements from the greatest down");
+        bench::expect(best.empty() && best.capacity() == ks[i], "take_sorted leaves the container empty");
+    }
+}
+
+//a copy throwing halfway leaves the target as it was and leaks nothing
+CHECK(top_k_copies) {
+    {
+        sjtu::top_k<fragile> best(1000), other(10);
+        for (long i = 0; i < 3000; ++i) best.push(fragile(i));
+        for (long i = 0; i < 10; ++i) other.push(fragile(-i));
+        std::vector<long> before = values(other);
+        long live = fragile::live;
+        fragile::countdown = 500;
+        bool thrown = false;
+        try {
+            other = best;
+        } catch (std::runtime_error &) {
+            thrown = true;
+        }
+        fragile::countdown = 0;
+        bench::expect(thrown, "the throwing copy is reported");
+        bench::expect(values(other) == before && other.capacity() == 10, "a failed copy assignment keeps the target");
+        bench::expect(fragile::live == live, "a failed copy assignment leaks no element");
+        fragile::countdown = 500;
+        thrown = false;
+        try {
+            sjtu::top_k<fragile> copy(best);
+        } catch (std::runtime_error &) {
+            thrown = true;
+        }
+        fragile::countdown = 0;
+        bench::expect(thrown && fragile::live == live, "a failed copy construction leaks no element");
+        other = best;
+        bench::expect(values(other) == values(best) && other.capacity() == 1000, "copy assignment copies every element");
+        sjtu::top_k<fragile> moved(std::move(other));
+        other = moved;
+        bench::expect(values(other) == values(moved), "a moved-from container can be assigned to");
+    }
+    bench::expect(fragile::live == 0, "every element is destroyed");
+}
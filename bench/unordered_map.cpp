@@ -0,0 +1,50 @@
+#include "bench.hpp"
+#include "unordered_map.hpp"
+#include "map.hpp"
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+    const size_t n = 1000000;
+
+    //the same operations on each map through the interface they share
+    template<class Map>
+    void run(const char *row, const std::vector<uint64_t> &keys, const std::vector<uint64_t> &order,
+             const std::vector<uint64_t> &absent) {
+        Map m;
+        bench::timer t;
+        for (size_t i = 0; i < n; ++i) m[keys[i]] = i;
+        bench::report(row, "insert", t.ms());
+        uint64_t sum = 0;
+        t = bench::timer();
+        for (size_t i = 0; i < n; ++i) sum += m.at(order[i]);
+        bench::report(row, "lookup hit", t.ms());
+        t = bench::timer();
+        for (size_t i = 0; i < n; ++i) sum += m.count(absent[i]);
+        bench::report(row, "lookup miss", t.ms());
+        t = bench::timer();
+        for (size_t i = 0; i < n; i += 2) sum += m.erase(order[i]);
+        bench::report(row, "erase half", t.ms());
+        bench::keep(sum);
+    }
+
+}
+
+BENCH(unordered_map_vs_map) {
+    bench::random rng(36);
+    std::vector<uint64_t> keys(n), order, absent(n);
+    //even keys are present and odd keys absent, so misses end all over the tree
+    for (size_t i = 0; i < n; ++i) keys[i] = rng() & ~1ull;
+    for (size_t i = 0; i < n; ++i) absent[i] = rng() | 1;
+    order = keys;
+    for (size_t i = n - 1; i > 0; --i) {
+        size_t j = rng.below(i + 1);
+        uint64_t tmp = order[i];
+        order[i] = order[j];
+        order[j] = tmp;
+    }
+    run<sjtu::unordered_map<uint64_t, uint64_t>>("sjtu::unordered_map", keys, order, absent);
+    run<sjtu::map<uint64_t, uint64_t>>("sjtu::map", keys, order, absent);
+    run<std::unordered_map<uint64_t, uint64_t>>("std::unordered_map", keys, order, absent);
+}
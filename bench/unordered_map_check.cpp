@@ -0,0 +1,147 @@
+#include "bench.hpp"
+#include "unordered_map.hpp"
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+
+    typedef sjtu::unordered_map<long, long> map_type;
+    typedef std::map<long, long> reference;
+
+    bool same(const map_type &m, const reference &ref) {
+        if (m.size() != ref.size()) return false;
+        size_t n = 0;
+        for (map_type::const_iterator it = m.cbegin(); it != m.cend(); ++it, ++n) {
+            reference::const_iterator r = ref.find(it->first);
+            if (r == ref.end() || r->second != it->second) return false;
+        }
+        return n == ref.size();
+    }
+
+    //a value that counts its copies and instances, and throws on the copy that brings countdown to 0
+    class counted {
+    public:
+        static long copies, live, countdown;
+        long value;
+
+        counted(long value = 0) : value(value) { ++live; }
+
+        counted(const counted &other) : value(other.value) {
+            if (countdown > 0 && --countdown == 0) throw std::runtime_error("copy");
+            ++copies, ++live;
+        }
+
+        counted(counted &&other) noexcept : value(other.value) { ++live; }
+
+        counted &operator=(const counted &other) {
+            value = other.value, ++copies;
+            return *this;
+        }
+
+        counted &operator=(counted &&other) noexcept {
+            value = other.value;
+            return *this;
+        }
+
+        ~counted() { --live; }
+    };
+
+    long counted::copies = 0, counted::live = 0, counted::countdown = 0;
+
+}
+
+CHECK(unordered_map_operations) {
+    bench::random rng(36);
+    map_type m;
+    reference ref;
+    for (size_t step = 1; step <= 100000; ++step) {
+        long key = (long) rng.below(5000), value = (long) rng.below(1000);
+        size_t op = rng.below(6);
+        if (op < 2) m[key] = value, ref[key] = value;
+        else if (op == 2) m.insert_or_assign(key, value), ref[key] = value;
+        else if (op == 3) m.try_emplace(key, value), ref.insert(std::make_pair(key, value));
+        else if (op == 4) bench::expect(m.erase(key) == ref.erase(key), "erase(key) counts the erased element");
+        else {
+            map_type::iterator it = m.find(key);
+            bench::expect((it != m.end()) == (ref.count(key) != 0), "find agrees with std::map");
+            if (it != m.end()) m.erase(it), ref.erase(key);
+        }
+        if (step % 10000 == 0) {
+            bench::expect(same(m, ref), "the map holds the same elements as std::map");
+            map_type copy(m), assigned;
+            assigned[-1] = -1;
+            assigned = copy;
+            bench::expect(same(copy, ref) && same(assigned, ref), "copies hold the same elements");
+            map_type moved(std::move(copy));
+            bench::expect(same(moved, ref) && copy.empty() && copy.bucket_count() == 0 && copy.begin() == copy.end(),
+                          "a moved-from map is empty and has no table");
+            bench::expect(copy.find(key) == copy.end() && copy.count(key) == 0 && copy.erase(key) == 0,
+                          "a moved-from map can be searched");
+            copy[key] = value;
+            bench::expect(copy.size() == 1 && copy.at(key) == value, "a moved-from map can be inserted into");
+            assigned = std::move(moved);
+            bench::expect(same(assigned, ref) && moved.empty(), "move assignment takes the table");
+            moved.reserve(100);
+            bench::expect(moved.bucket_count() >= 100, "a moved-from map can reserve");
+        }
+    }
+}
+
+CHECK(unordered_map_copies) {
+    typedef sjtu::unordered_map<long, counted> counted_map;
+    counted::copies = 0;
+    {
+        counted_map m;
+        for (long i = 0; i < 10000; ++i) {
+            if (i % 3 == 0) m.try_emplace(i, counted(i));
+            else if (i % 3 == 1) m.try_emplace(i, i);
+            else m[i].value = i;
+        }
+        bench::expect(counted::copies == 0, "try_emplace and operator[] copy no value");
+        counted_map other;
+        for (long i = 0; i < 1000; ++i) other.insert(counted_map::value_type(i + 20000, counted(i)));
+        long inserted = 0;
+        for (long i = 0; i < 1000; ++i) {
+            const counted_map::value_type value(i + 10000, counted(i));
+            long copies = counted::copies;
+            m.insert(value);
+            inserted += counted::copies - copies;
+        }
+        bench::expect(inserted == 1000, "insert(value) copies the value once");
+
+        //a copy throwing halfway leaves the target as it was and leaks nothing
+        long live = counted::live;
+        counted::countdown = 5000;
+        bool thrown = false;
+        try {
+            other = m;
+        } catch (std::runtime_error &) {
+            thrown = true;
+        }
+        counted::countdown = 0;
+        bench::expect(thrown, "the throwing copy is reported");
+        bench::expect(other.size() == 1000 && other.at(20999).value == 999, "a failed copy assignment keeps the target");
+        bench::expect(counted::live == live, "a failed copy assignment leaks no element");
+        counted::countdown = 5000;
+        thrown = false;
+        try {
+            counted_map copy(m);
+        } catch (std::runtime_error &) {
+            thrown = true;
+        }
+        counted::countdown = 0;
+        bench::expect(thrown && counted::live == live, "a failed copy construction leaks no element");
+    }
+    bench::expect(counted::live == 0, "every value is destroyed");
+
+    //move-only values
+    sjtu::unordered_map<long, std::unique_ptr<long>> owners;
+    for (long i = 0; i < 1000; ++i) owners.try_emplace(i, new long(i));
+    owners[1000].reset(new long(1000));
+    long sum = 0;
+    for (sjtu::unordered_map<long, std::unique_ptr<long>>::iterator it = owners.begin(); it != owners.end(); ++it)
+        sum += *it->second;
+    bench::expect(owners.size() == 1001 && sum == 1000 * 1001 / 2, "move-only values can be stored");
+}
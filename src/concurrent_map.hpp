@@ -0,0 +1,246 @@
+/**
+ * implement a map shared by several threads
+ */
+#ifndef SJTU_CONCURRENT_MAP_HPP
+#define SJTU_CONCURRENT_MAP_HPP
+
+#include <functional>
+#include <cstddef>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include "utility.hpp"
+#include "exceptions.hpp"
+#include "map.hpp"
+
+namespace sjtu {
+
+    /**
+     * runs the two halves of a map set operation on two threads while fewer than
+     * max_threads are busy, and one after another otherwise.
+     * pass it to map::set_union and the like, one object for one call.
+     * an exception of either half is rethrown on the calling thread once both have finished.
+     */
+    class map_thread_fork {
+    private:
+        mutable std::atomic<unsigned> running;
+        unsigned limit;
+
+        //the body of the helper thread, keeping the exception of f for the caller
+        template<class F>
+        class Helper {
+        public:
+            F *f;
+            std::exception_ptr *error;
+
+            void operator()() const {
+                try {
+                    (*f)();
+                } catch (...) {
+                    *error = std::current_exception();
+                }
+            }
+        };
+
+        //joins the helper and gives its place back however the caller leaves
+        class Join {
+        public:
+            std::thread *helper;
+            std::atomic<unsigned> *running;
+
+            ~Join() {
+                if (helper->joinable()) helper->join();
+                running->fetch_sub(1);
+            }
+        };
+
+    public:
+        explicit map_thread_fork(unsigned max_threads = std::thread::hardware_concurrency())
+                : running(1), limit(max_threads ? max_threads : 1) {}
+
+        template<class F, class G>
+        void operator()(F f, G g) const {
+            if (running.fetch_add(1) >= limit) {
+                running.fetch_sub(1);
+                f(), g();
+                return;
+            }
+            std::exception_ptr error;
+            std::thread helper;
+            {
+                Join guard = {&helper, &running};
+                helper = std::thread(Helper<F>{&f, &error});
+                g();
+            }
+            if (error) std::rethrow_exception(error);
+        }
+    };
+
+    /**
+     * a hash-sharded set of sjtu::map partitions, each behind its own reader/writer lock.
+     * lookups of different keys rarely meet on the same lock, and lookups of the same shard
+     * only share it, so read throughput grows with the number of cores.
+     * elements are only reachable by key: there is no ordered iteration across shards.
+     */
+    template<
+            class Key,
+            class T,
+            class Compare = std::less<Key>,
+            class Hash = std::hash<Key>
+    >
+    class concurrent_map {
+    public:
+        typedef pair<const Key, T> value_type;
+
+    private:
+        //one cache line apart at least, so that neighbouring locks do not share a line
+        class Shard {
+        public:
+            mutable std::shared_timed_mutex lock;
+            map<Key, T, Compare> partition;
+            char padding[64];
+
+            Shard() {}
+        };
+
+        typedef std::shared_lock<std::shared_timed_mutex> read_lock;
+        typedef std::unique_lock<std::shared_timed_mutex> write_lock;
+
+        Shard *shards;
+        size_t mask;
+        Hash hash;
+
+        Shard &shardOf(const Key &key) const {
+            size_t h = hash(key);
+            //mix the high bits in, std::hash is the identity for integers
+            h ^= h >> 16;
+            h *= (size_t) 0x9E3779B97F4A7C15ull;
+            return shards[(h >> (sizeof(size_t) * 4)) & mask];
+        }
+
+    public:
+        /**
+         * shard_count is rounded up to a power of 2
+         */
+        explicit concurrent_map(size_t shard_count = 64, const Compare &comp = Compare(), const Hash &h = Hash())
+                : mask(1), hash(h) {
+            while (mask < shard_count) mask <<= 1;
+            shards = new Shard[mask];
+            for (size_t i = 0; i < mask; ++i) shards[i].partition = map<Key, T, Compare>(comp);
+            --mask;
+        }
+
+        concurrent_map(const concurrent_map &other) = delete;
+
+        concurrent_map &operator=(const concurrent_map &other) = delete;
+
+        ~concurrent_map() {
+            delete[] shards;
+        }
+
+        /**
+         * copy the value of key into res, false for not found
+         */
+        bool find(const Key &key, T &res) const {
+            Shard &shard = shardOf(key);
+            read_lock guard(shard.lock);
+            typename map<Key, T, Compare>::const_iterator it = shard.partition.find(key);
+            if (it == shard.partition.cend()) return false;
+            res = it->second;
+            return true;
+        }
+
+        /**
+         * throw index_out_of_bound if key does not exist
+         */
+        T at(const Key &key) const {
+            Shard &shard = shardOf(key);
+            read_lock guard(shard.lock);
+            return shard.partition.at(key);
+        }
+
+        size_t count(const Key &key) const {
+            Shard &shard = shardOf(key);
+            read_lock guard(shard.lock);
+            return shard.partition.count(key);
+        }
+
+        /**
+         * call fn(const T &) under the shared lock, false for not found
+         */
+        template<class Function>
+        bool visit(const Key &key, Function fn) const {
+            Shard &shard = shardOf(key);
+            read_lock guard(shard.lock);
+            typename map<Key, T, Compare>::const_iterator it = shard.partition.find(key);
+            if (it == shard.partition.cend()) return false;
+            fn(it->second);
+            return true;
+        }
+
+        /**
+         * call fn(T &) under the exclusive lock, false for not found
+         */
+        template<class Function>
+        bool update(const Key &key, Function fn) {
+            Shard &shard = shardOf(key);
+            write_lock guard(shard.lock);
+            typename map<Key, T, Compare>::iterator it = shard.partition.find(key);
+            if (it == shard.partition.end()) return false;
+            fn(it->second);
+            return true;
+        }
+
+        /**
+         * false if the key has existed
+         */
+        bool insert(const value_type &value) {
+            Shard &shard = shardOf(value.first);
+            write_lock guard(shard.lock);
+            return shard.partition.insert(value).second;
+        }
+
+        /**
+         * true for insertion and false for assignment
+         */
+        bool insert_or_assign(const Key &key, const T &value) {
+            Shard &shard = shardOf(key);
+            write_lock guard(shard.lock);
+            return shard.partition.insert_or_assign(key, value).second;
+        }
+
+        size_t erase(const Key &key) {
+            Shard &shard = shardOf(key);
+            write_lock guard(shard.lock);
+            return shard.partition.erase(key);
+        }
+
+        /**
+         * shards are counted one by one, so the result is exact only without concurrent writers
+         */
+        size_t size() const {
+            size_t res = 0;
+            for (size_t i = 0; i <= mask; ++i) {
+                read_lock guard(shards[i].lock);
+                res += shards[i].partition.size();
+            }
+            return res;
+        }
+
+        bool empty() const {
+            return size() == 0;
+        }
+
+        void clear() {
+            for (size_t i = 0; i <= mask; ++i) {
+                write_lock guard(shards[i].lock);
+                shards[i].partition.clear();
+            }
+        }
+    };
+
+}
+
+#endif
@@ -0,0 +1,592 @@
+/**
+ * implement a map on sorted arrays for data built once and read often
+ */
+#ifndef SJTU_FLAT_MAP_HPP
+#define SJTU_FLAT_MAP_HPP
+
+// only for std::less<T>
+#include <functional>
+#include <cstddef>
+#include <new>
+#include "utility.hpp"
+#include "exceptions.hpp"
+
+namespace sjtu {
+
+    /**
+     * keys and values are kept in two separate arrays sorted by key, so a lookup only
+     * touches the keys and a scan reads memory in order.
+     * a range is built with one sort in O(n log n); insert() and erase() shift the arrays
+     * and cost O(n), which suits data that is queried far more often than modified.
+     * iterators are random access, and dereferencing one yields pair<const Key &, T &>
+     * instead of a reference to a stored pair.
+     * insert() and erase() invalidate every iterator.
+     */
+    template<
+            class Key,
+            class T,
+            class Compare = std::less<Key>
+    >
+    class flat_map {
+    public:
+        typedef pair<const Key, T> value_type;
+        typedef pair<const Key &, T &> reference;
+        typedef pair<const Key &, const T &> const_reference;
+
+    private:
+        //raw memory, the first _size of each are alive
+        Key *keys;
+        T *values;
+        size_t _size, capacity;
+        Compare cmp;
+
+        static Key *allocateKeys(size_t n) {
+            return n ? static_cast<Key *>(::operator new(n * sizeof(Key))) : nullptr;
+        }
+
+        static T *allocateValues(size_t n) {
+            return n ? static_cast<T *>(::operator new(n * sizeof(T))) : nullptr;
+        }
+
+        void release() {
+            for (size_t i = 0; i < _size; ++i) keys[i].~Key(), values[i].~T();
+            ::operator delete(keys);
+            ::operator delete(values);
+        }
+
+        void reallocate(size_t cap) {
+            Key *newKeys = allocateKeys(cap);
+            T *newValues = allocateValues(cap);
+            for (size_t i = 0; i < _size; ++i) {
+                new(newKeys + i) Key(std::move(keys[i]));
+                new(newValues + i) T(std::move(values[i]));
+                keys[i].~Key(), values[i].~T();
+            }
+            ::operator delete(keys);
+            ::operator delete(values);
+            keys = newKeys, values = newValues, capacity = cap;
+        }
+
+        //for the copy constructor only, everything built so far is freed if an allocation or a copy throws
+        void copyFrom(const flat_map &other) {
+            keys = allocateKeys(other._size);
+            try {
+                values = allocateValues(other._size);
+            } catch (...) {
+                ::operator delete(keys);
+                throw;
+            }
+            capacity = other._size, _size = 0;
+            try {
+                for (; _size < other._size; ++_size) {
+                    new(keys + _size) Key(other.keys[_size]);
+                    try {
+                        new(values + _size) T(other.values[_size]);
+                    } catch (...) {
+                        keys[_size].~Key();
+                        throw;
+                    }
+                }
+            } catch (...) {
+                release();
+                throw;
+            }
+        }
+
+        /**
+         * the index of the first key not less than key.
+         * the halving step compiles to a conditional move, so the search runs without
+         * mispredicted branches and only its memory loads depend on each other
+         */
+        size_t lowerIndex(const Key &key) const {
+            if (_size == 0) return 0;
+            const Key *base = keys;
+            for (size_t n = _size, half; n > 1; n -= half) {
+                half = n >> 1;
+                base = cmp(base[half], key) ? base + half : base;
+            }
+            return (base - keys) + cmp(*base, key);
+        }
+
+        size_t upperIndex(const Key &key) const {
+            if (_size == 0) return 0;
+            const Key *base = keys;
+            for (size_t n = _size, half; n > 1; n -= half) {
+                half = n >> 1;
+                base = cmp(key, base[half]) ? base : base + half;
+            }
+            return (base - keys) + !cmp(key, *base);
+        }
+
+        //index of key, _size for not found
+        size_t locate(const Key &key) const {
+            size_t i = lowerIndex(key);
+            return (i < _size && !cmp(key, keys[i])) ? i : _size;
+        }
+
+        //insert before index i, the caller has checked that key belongs there
+        void insertAt(size_t i, const Key &key, const T &value) {
+            if (_size == capacity) reallocate(capacity ? capacity << 1 : 8);
+            if (i == _size) {
+                new(keys + _size) Key(key);
+                new(values + _size) T(value);
+                ++_size;
+                return;
+            }
+            new(keys + _size) Key(std::move(keys[_size - 1]));
+            new(values + _size) T(std::move(values[_size - 1]));
+            for (size_t k = _size - 1; k > i; --k) {
+                keys[k] = std::move(keys[k - 1]);
+                values[k] = std::move(values[k - 1]);
+            }
+            keys[i] = key, values[i] = value;
+            ++_size;
+        }
+
+        void eraseAt(size_t i) {
+            for (size_t k = i; k + 1 < _size; ++k) {
+                keys[k] = std::move(keys[k + 1]);
+                values[k] = std::move(values[k + 1]);
+            }
+            --_size;
+            keys[_size].~Key(), values[_size].~T();
+        }
+
+        //merge sort of the indexes in order[lo, hi) by key, stable so the first of equal keys comes first
+        void sortIndexes(const Key *src, size_t *order, size_t *buffer, size_t lo, size_t hi) const {
+            if (hi - lo < 2) return;
+            size_t mid = (lo + hi) >> 1;
+            sortIndexes(src, order, buffer, lo, mid);
+            sortIndexes(src, order, buffer, mid, hi);
+            if (!cmp(src[order[mid]], src[order[mid - 1]])) return;
+            size_t i = lo, j = mid, k = lo;
+            while (i < mid && j < hi) buffer[k++] = cmp(src[order[j]], src[order[i]]) ? order[j++] : order[i++];
+            while (i < mid) buffer[k++] = order[i++];
+            while (j < hi) buffer[k++] = order[j++];
+            for (k = lo; k < hi; ++k) order[k] = buffer[k];
+        }
+
+        class arrow_proxy {
+        private:
+            reference ref;
+        public:
+            explicit arrow_proxy(const reference &ref) : ref(ref) {}
+
+            reference *operator->() {
+                return &ref;
+            }
+        };
+
+        class const_arrow_proxy {
+        private:
+            const_reference ref;
+        public:
+            explicit const_arrow_proxy(const const_reference &ref) : ref(ref) {}
+
+            const_reference *operator->() {
+                return &ref;
+            }
+        };
+
+    public:
+        class const_iterator;
+
+        class iterator {
+            friend flat_map;
+        private:
+            size_t index;
+            flat_map *source;
+
+            iterator shifted(long long n) const {
+                long long res = (long long) index + n;
+                if (source == nullptr || res < 0 || res > (long long) source->_size) throw invalid_iterator();
+                return iterator((size_t) res, source);
+            }
+
+        public:
+
+            iterator(size_t index, flat_map *source) : index(index), source(source) {}
+
+            iterator() : index(0), source(nullptr) {}
+
+            iterator(const iterator &other) : index(other.index), source(other.source) {}
+
+            iterator &operator=(const iterator &other) = default;
+
+            /**
+             * throw invalid_iterator if the result is out of [begin(), end()]
+             */
+            iterator operator+(const int &n) const {
+                return shifted(n);
+            }
+
+            iterator operator-(const int &n) const {
+                return shifted(-(long long) n);
+            }
+
+            iterator &operator+=(const int &n) {
+                return *this = shifted(n);
+            }
+
+            iterator &operator-=(const int &n) {
+                return *this = shifted(-(long long) n);
+            }
+
+            iterator operator++(int) {
+                iterator tmp(*this);
+                *this = shifted(1);
+                return tmp;
+            }
+
+            iterator &operator++() {
+                return *this = shifted(1);
+            }
+
+            iterator operator--(int) {
+                iterator tmp(*this);
+                *this = shifted(-1);
+                return tmp;
+            }
+
+            iterator &operator--() {
+                return *this = shifted(-1);
+            }
+
+            reference operator*() const {
+                if (source == nullptr || index >= source->_size) throw invalid_iterator();
+                return reference(source->keys[index], source->values[index]);
+            }
+
+            arrow_proxy operator->() const {
+                return arrow_proxy(**this);
+            }
+
+            bool operator==(const iterator &rhs) const {
+                return (index == rhs.index && source == rhs.source);
+            }
+
+            bool operator==(const const_iterator &rhs) const {
+                return (index == rhs.index && source == rhs.source);
+            }
+
+            bool operator!=(const iterator &rhs) const {
+                return (index != rhs.index || source != rhs.source);
+            }
+
+            bool operator!=(const const_iterator &rhs) const {
+                return (index != rhs.index || source != rhs.source);
+            }
+        };
+
+        class const_iterator {
+            friend flat_map;
+        private:
+            size_t index;
+            const flat_map *source;
+
+            const_iterator shifted(long long n) const {
+                long long res = (long long) index + n;
+                if (source == nullptr || res < 0 || res > (long long) source->_size) throw invalid_iterator();
+                return const_iterator((size_t) res, source);
+            }
+
+        public:
+
+            const_iterator(size_t index, const flat_map *source) : index(index), source(source) {}
+
+            const_iterator() : index(0), source(nullptr) {}
+
+            const_iterator(const const_iterator &other) : index(other.index), source(other.source) {}
+
+            const_iterator(const iterator &other) : index(other.index), source(other.source) {}
+
+            const_iterator &operator=(const const_iterator &other) = default;
+
+            const_iterator operator+(const int &n) const {
+                return shifted(n);
+            }
+
+            const_iterator operator-(const int &n) const {
+                return shifted(-(long long) n);
+            }
+
+            const_iterator &operator+=(const int &n) {
+                return *this = shifted(n);
+            }
+
+            const_iterator &operator-=(const int &n) {
+                return *this = shifted(-(long long) n);
+            }
+
+            const_iterator operator++(int) {
+                const_iterator tmp(*this);
+                *this = shifted(1);
+                return tmp;
+            }
+
+            const_iterator &operator++() {
+                return *this = shifted(1);
+            }
+
+            const_iterator operator--(int) {
+                const_iterator tmp(*this);
+                *this = shifted(-1);
+                return tmp;
+            }
+
+            const_iterator &operator--() {
+                return *this = shifted(-1);
+            }
+
+            const_reference operator*() const {
+                if (source == nullptr || index >= source->_size) throw invalid_iterator();
+                return const_reference(source->keys[index], source->values[index]);
+            }
+
+            const_arrow_proxy operator->() const {
+                return const_arrow_proxy(**this);
+            }
+
+            bool operator==(const iterator &rhs) const {
+                return (index == rhs.index && source == rhs.source);
+            }
+
+            bool operator==(const const_iterator &rhs) const {
+                return (index == rhs.index && source == rhs.source);
+            }
+
+            bool operator!=(const iterator &rhs) const {
+                return (index != rhs.index || source != rhs.source);
+            }
+
+            bool operator!=(const const_iterator &rhs) const {
+                return (index != rhs.index || source != rhs.source);
+            }
+        };
+
+        explicit flat_map(const Compare &comp = Compare())
+                : keys(nullptr), values(nullptr), _size(0), capacity(0), cmp(comp) {}
+
+        /**
+         * build from an unsorted range with one stable sort, the first of equal keys is kept.
+         * each element is copied once, then sorted by moves within the same arrays
+         */
+        template<class InputIterator>
+        flat_map(InputIterator first, InputIterator last, const Compare &comp = Compare())
+                : keys(nullptr), values(nullptr), _size(0), capacity(0), cmp(comp) {
+            flat_map raw(comp);
+            for (; first != last; ++first) {
+                if (raw._size == raw.capacity) raw.reallocate(raw.capacity ? raw.capacity << 1 : 8);
+                new(raw.keys + raw._size) Key((*first).first);
+                new(raw.values + raw._size) T((*first).second);
+                ++raw._size;
+            }
+            if (!raw._size) return;
+            size_t n = raw._size, *order = new size_t[n], *buffer = new size_t[n];
+            for (size_t i = 0; i < n; ++i) order[i] = i;
+            sortIndexes(raw.keys, order, buffer, 0, n);
+            delete[] buffer;
+            //slot i takes the element from slot order[i], one cycle of the permutation at a time
+            for (size_t i = 0; i < n; ++i) {
+                if (order[i] == i) continue;
+                Key key(std::move(raw.keys[i]));
+                T value(std::move(raw.values[i]));
+                size_t j = i;
+                for (size_t next; (next = order[j]) != i; j = next) {
+                    raw.keys[j] = std::move(raw.keys[next]);
+                    raw.values[j] = std::move(raw.values[next]);
+                    order[j] = j;
+                }
+                raw.keys[j] = std::move(key);
+                raw.values[j] = std::move(value);
+                order[j] = j;
+            }
+            delete[] order;
+            size_t m = 1;
+            for (size_t i = 1; i < n; ++i) {
+                if (!cmp(raw.keys[m - 1], raw.keys[i])) continue;
+                if (m != i) {
+                    raw.keys[m] = std::move(raw.keys[i]);
+                    raw.values[m] = std::move(raw.values[i]);
+                }
+                ++m;
+            }
+            while (raw._size > m) raw.eraseAt(raw._size - 1);
+            keys = raw.keys, values = raw.values;
+            _size = raw._size, capacity = raw.capacity;
+            raw.keys = nullptr, raw.values = nullptr;
+            raw._size = raw.capacity = 0;
+        }
+
+        flat_map(const flat_map &other) : cmp(other.cmp) {
+            copyFrom(other);
+        }
+
+        flat_map(flat_map &&other)
+                : keys(other.keys), values(other.values), _size(other._size), capacity(other.capacity),
+                  cmp(other.cmp) {
+            other.keys = nullptr, other.values = nullptr;
+            other._size = other.capacity = 0;
+        }
+
+        //this map is left untouched if a copy throws
+        flat_map &operator=(const flat_map &other) {
+            if (this == &other) return *this;
+            flat_map tmp(other);
+            return *this = std::move(tmp);
+        }
+
+        flat_map &operator=(flat_map &&other) {
+            if (this == &other) return *this;
+            release();
+            keys = other.keys, values = other.values, _size = other._size, capacity = other.capacity;
+            cmp = other.cmp;
+            other.keys = nullptr, other.values = nullptr;
+            other._size = other.capacity = 0;
+            return *this;
+        }
+
+        ~flat_map() {
+            release();
+        }
+
+        /**
+         * throw index_out_of_bound if key does not exist
+         */
+        T &at(const Key &key) {
+            size_t i = locate(key);
+            if (i == _size) throw index_out_of_bound();
+            return values[i];
+        }
+
+        const T &at(const Key &key) const {
+            size_t i = locate(key);
+            if (i == _size) throw index_out_of_bound();
+            return values[i];
+        }
+
+        /**
+         * insert a default value in O(n) if key does not exist
+         */
+        T &operator[](const Key &key) {
+            size_t i = lowerIndex(key);
+            if (i == _size || cmp(key, keys[i])) insertAt(i, key, T());
+            return values[i];
+        }
+
+        const T &operator[](const Key &key) const {
+            return at(key);
+        }
+
+        iterator begin() {
+            return iterator(0, this);
+        }
+
+        const_iterator begin() const {
+            return const_iterator(0, this);
+        }
+
+        const_iterator cbegin() const {
+            return const_iterator(0, this);
+        }
+
+        iterator end() {
+            return iterator(_size, this);
+        }
+
+        const_iterator end() const {
+            return const_iterator(_size, this);
+        }
+
+        const_iterator cend() const {
+            return const_iterator(_size, this);
+        }
+
+        bool empty() const {
+            return _size == 0;
+        }
+
+        size_t size() const {
+            return _size;
+        }
+
+        Compare key_comp() const {
+            return cmp;
+        }
+
+        void clear() {
+            release();
+            keys = nullptr, values = nullptr;
+            _size = capacity = 0;
+        }
+
+        void reserve(size_t n) {
+            if (n > capacity) reallocate(n);
+        }
+
+        /**
+         * O(n), the bool is false if the key has existed
+         */
+        pair<iterator, bool> insert(const value_type &value) {
+            size_t i = lowerIndex(value.first);
+            if (i < _size && !cmp(value.first, keys[i])) return pair<iterator, bool>(iterator(i, this), false);
+            insertAt(i, value.first, value.second);
+            return pair<iterator, bool>(iterator(i, this), true);
+        }
+
+        /**
+         * O(n), throw invalid_iterator if pos is end() or of another map
+         */
+        void erase(iterator pos) {
+            if (pos.source != this || pos.index >= _size) throw invalid_iterator();
+            eraseAt(pos.index);
+        }
+
+        /**
+         * return the number of erased elements (0 or 1)
+         */
+        size_t erase(const Key &key) {
+            size_t i = locate(key);
+            if (i == _size) return 0;
+            eraseAt(i);
+            return 1;
+        }
+
+        size_t count(const Key &key) const {
+            return locate(key) != _size;
+        }
+
+        iterator find(const Key &key) {
+            return iterator(locate(key), this);
+        }
+
+        const_iterator find(const Key &key) const {
+            return const_iterator(locate(key), this);
+        }
+
+        /**
+         * the first element whose key is not less than key, end() for none
+         */
+        iterator lower_bound(const Key &key) {
+            return iterator(lowerIndex(key), this);
+        }
+
+        const_iterator lower_bound(const Key &key) const {
+            return const_iterator(lowerIndex(key), this);
+        }
+
+        /**
+         * the first element whose key is greater than key, end() for none
+         */
+        iterator upper_bound(const Key &key) {
+            return iterator(upperIndex(key), this);
+        }
+
+        const_iterator upper_bound(const Key &key) const {
+            return const_iterator(upperIndex(key), this);
+        }
+    };
+
+}
+
+#endif
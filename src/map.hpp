@@ -6,16 +6,349 @@
 
 // only for std::less<T>
 #include <functional>
+// only for std::is_trivially_copyable<T> in map_serializer
+#include <type_traits>
 #include <cstddef>
+#include <cstring>
 #include "utility.hpp"
 #include "exceptions.hpp"
 
 namespace sjtu {
 
+    //size of the subtree kept on every map node, empty unless order statistic is enabled
+    template<bool Enable>
+    class map_subtree_size {
+    public:
+        size_t getSize() const {
+            return 0;
+        }
+
+        void setSize(size_t) {}
+    };
+
+    template<>
+    class map_subtree_size<true> {
+    public:
+        size_t subtreeSize;
+
+        map_subtree_size() : subtreeSize(1) {}
+
+        size_t getSize() const {
+            return subtreeSize;
+        }
+
+        void setSize(size_t n) {
+            subtreeSize = n;
+        }
+    };
+
+    /**
+     * summary of the subtree kept on every map node, empty unless a Monoid is given.
+     * a Monoid provides
+     *     typedef ... summary_type;
+     *     static summary_type identity();
+     *     static summary_type lift(const Key &key, const T &value);
+     *     static summary_type combine(const summary_type &lhs, const summary_type &rhs);
+     * where combine is associative, identity is its neutral element and lhs holds the smaller keys.
+     */
+    template<class Monoid>
+    class map_subtree_summary {
+    public:
+        typedef typename Monoid::summary_type summary_type;
+        static const bool enabled = true;
+
+        summary_type summary;
+
+        template<class Key, class T, class Node>
+        void summarize(const Key &key, const T &value, const Node *lch, const Node *rch) {
+            summary = Monoid::lift(key, value);
+            if (lch) summary = Monoid::combine(lch->summary, summary);
+            if (rch) summary = Monoid::combine(summary, rch->summary);
+        }
+
+        //whether summary is up to date, for map::valid() only, which needs summary_type to have ==
+        template<class Key, class T, class Node>
+        bool summarized(const Key &key, const T &value, const Node *lch, const Node *rch) const {
+            map_subtree_summary expected;
+            expected.summarize(key, value, lch, rch);
+            return expected.summary == summary;
+        }
+    };
+
+    template<>
+    class map_subtree_summary<void> {
+    public:
+        typedef void summary_type;
+        static const bool enabled = false;
+
+        template<class Key, class T, class Node>
+        void summarize(const Key &, const T &, const Node *, const Node *) {}
+
+        template<class Key, class T, class Node>
+        bool summarized(const Key &, const T &, const Node *, const Node *) const {
+            return true;
+        }
+    };
+
+    //a Monoid for map summing up the values
+    template<class T>
+    class map_sum {
+    public:
+        typedef T summary_type;
+
+        static T identity() {
+            return T();
+        }
+
+        template<class Key>
+        static T lift(const Key &, const T &value) {
+            return value;
+        }
+
+        static T combine(const T &lhs, const T &rhs) {
+            return lhs + rhs;
+        }
+    };
+
+    /**
+     * header of the binary format of map::save(), 32 bytes in native byte order.
+     * it is followed by count records of key and value in ascending order of keys.
+     * keySize and valueSize are the fixed sizes of the two, or 0 if they vary in length;
+     * with both fixed the records have one stride and map_view searches them in place.
+     * flags is reserved and 0 in version 1.
+     */
+    class map_header {
+    public:
+        static const unsigned int currentVersion = 1;
+
+        char magic[8];
+        unsigned int version, flags, keySize, valueSize;
+        unsigned long long count;
+
+        static const char *expectedMagic() {
+            return "SJTUMAP";
+        }
+    };
+
+    /**
+     * how map::save() writes a key or a value and map::load() reads it back:
+     *     static const unsigned int fixedSize;  //0 for variable length
+     *     template<class OStream> static void write(OStream &os, const T &value);
+     *     template<class IStream> static void read(IStream &is, T &value);
+     * trivially copyable types are written as raw bytes and std::string as its length and
+     * characters, specialize it for others
+     */
+    template<class T, bool Trivial = std::is_trivially_copyable<T>::value>
+    class map_serializer;
+
+    template<class T>
+    class map_serializer<T, true> {
+    public:
+        static const unsigned int fixedSize = sizeof(T);
+
+        template<class OStream>
+        static void write(OStream &os, const T &value) {
+            os.write(reinterpret_cast<const char *>(&value), sizeof(T));
+        }
+
+        template<class IStream>
+        static void read(IStream &is, T &value) {
+            is.read(reinterpret_cast<char *>(&value), sizeof(T));
+        }
+    };
+
+    template<class Char, class Traits, class Alloc>
+    class map_serializer<std::basic_string<Char, Traits, Alloc>, false> {
+    public:
+        static const unsigned int fixedSize = 0;
+
+        template<class OStream>
+        static void write(OStream &os, const std::basic_string<Char, Traits, Alloc> &value) {
+            unsigned long long n = value.size();
+            os.write(reinterpret_cast<const char *>(&n), sizeof(n));
+            os.write(reinterpret_cast<const char *>(value.data()), n * sizeof(Char));
+        }
+
+        //read in pieces, so that a broken length fails on the stream rather than on allocation
+        template<class IStream>
+        static void read(IStream &is, std::basic_string<Char, Traits, Alloc> &value) {
+            unsigned long long n = 0;
+            is.read(reinterpret_cast<char *>(&n), sizeof(n));
+            value.clear();
+            Char buffer[256];
+            while (is && n) {
+                size_t piece = (n < 256) ? (size_t) n : 256;
+                is.read(reinterpret_cast<char *>(buffer), piece * sizeof(Char));
+                value.append(buffer, piece);
+                n -= piece;
+            }
+        }
+    };
+
+    /**
+     * Compare may provide a three-way member
+     *     int compare(const Key &lhs, const Key &rhs) const
+     * returning a negative number, 0 or a positive number, such as std::string::compare,
+     * so that map resolves each level of the tree with a single call.
+     */
+    template<class Compare, class Key>
+    class map_three_way {
+    private:
+        template<class C>
+        static char test(decltype(std::declval<const C &>().compare(std::declval<const Key &>(),
+                                                                    std::declval<const Key &>())) *);
+
+        template<class C>
+        static long test(...);
+
+    public:
+        static const bool value = sizeof(test<Compare>(nullptr)) == 1;
+    };
+
+    template<class Compare, class Key, bool ThreeWay = map_three_way<Compare, Key>::value>
+    class map_key_compare {
+    public:
+        static int compare(const Compare &cmp, const Key &lhs, const Key &rhs) {
+            if (cmp(lhs, rhs)) return -1;
+            return cmp(rhs, lhs) ? 1 : 0;
+        }
+    };
+
+    template<class Compare, class Key>
+    class map_key_compare<Compare, Key, true> {
+    public:
+        static int compare(const Compare &cmp, const Key &lhs, const Key &rhs) {
+            return cmp.compare(lhs, rhs);
+        }
+    };
+
+    //links of a map node besides its children.
+    //the threaded layout keeps pre/next pointers so that iteration takes O(1)
+    template<class Node, bool Compact>
+    class map_node_links {
+    private:
+        int color;
+        Node *next, *pre, *parent;
+    public:
+        map_node_links() : color(0), next(nullptr), pre(nullptr), parent(nullptr) {}
+
+        Node *getParent() const {
+            return parent;
+        }
+
+        void setParent(Node *ptr) {
+            parent = ptr;
+        }
+
+        int getColor() const {
+            return color;
+        }
+
+        void setColor(int col) {
+            color = col;
+        }
+
+        Node *getNext() const {
+            return next;
+        }
+
+        Node *getPre() const {
+            return pre;
+        }
+
+        void setNext(Node *ptr) {
+            next = ptr;
+        }
+
+        void setPre(Node *ptr) {
+            pre = ptr;
+        }
+
+        //leave the thread before being destroyed
+        void unlink() {
+            if (next)
+                next->setPre(pre);
+            if (pre)
+                pre->setNext(next);
+        }
+    };
+
+    //the compact layout keeps the color in the lowest bit of the parent pointer and has no thread,
+    //neighbours are found through the tree, which is amortized O(1) along a whole iteration
+    template<class Node>
+    class map_node_links<Node, true> {
+    private:
+        size_t parentColor;
+    public:
+        map_node_links() : parentColor(0) {}
+
+        Node *getParent() const {
+            return reinterpret_cast<Node *>(parentColor & ~(size_t) 1);
+        }
+
+        void setParent(Node *ptr) {
+            parentColor = reinterpret_cast<size_t>(ptr) | (parentColor & 1);
+        }
+
+        int getColor() const {
+            return (int) (parentColor & 1);
+        }
+
+        void setColor(int col) {
+            parentColor = (parentColor & ~(size_t) 1) | (size_t) col;
+        }
+
+        Node *getNext() const {
+            const Node *ptr = static_cast<const Node *>(this);
+            if (ptr->rch) {
+                for (ptr = ptr->rch; ptr->lch; ptr = ptr->lch);
+                return const_cast<Node *>(ptr);
+            }
+            while (ptr->getParent() && ptr->getParent()->rch == ptr) ptr = ptr->getParent();
+            return ptr->getParent();
+        }
+
+        Node *getPre() const {
+            const Node *ptr = static_cast<const Node *>(this);
+            if (ptr->lch) {
+                for (ptr = ptr->lch; ptr->rch; ptr = ptr->rch);
+                return const_cast<Node *>(ptr);
+            }
+            while (ptr->getParent() && ptr->getParent()->lch == ptr) ptr = ptr->getParent();
+            return ptr->getParent();
+        }
+
+        void setNext(Node *) {}
+
+        void setPre(Node *) {}
+
+        void unlink() {}
+    };
+
+    //runs both halves of a map set operation one after another
+    class map_sequential_fork {
+    public:
+        template<class F, class G>
+        void operator()(F f, G g) const {
+            f(), g();
+        }
+    };
+
+    /**
+     * OrderStatistic keeps subtree sizes on the nodes, which enables
+     * select(), rank() and iterator + n in O(log n).
+     * CompactNode drops the pre/next thread and packs the color into the parent pointer,
+     * which saves 24 bytes per node at the cost of walking the tree on iteration.
+     * Monoid keeps a summary of every subtree, which enables aggregate() over a key interval
+     * in O(log n), see map_subtree_summary.
+     */
     template<
             class Key,
             class T,
-            class Compare = std::less<Key>
+            class Compare = std::less<Key>,
+            bool OrderStatistic = false,
+            bool CompactNode = false,
+            class Monoid = void
     >
     class map {
     private:
@@ -24,27 +357,23 @@ namespace sjtu {
             red, black
         };
 
-        class RedBlackNode {
+        class RedBlackNode : public map_subtree_size<OrderStatistic>,
+                             public map_subtree_summary<Monoid>,
+                             public map_node_links<RedBlackNode, CompactNode> {
         public:
-            COLOR nodeColor;
-            RedBlackNode *next, *pre, *parent, *lch, *rch;
+            RedBlackNode *lch, *rch;
             pair<const Key, T> record;
 
-            RedBlackNode(const Key &k, const T &v, COLOR col = red) : record(k, v),
-                                                                      parent(nullptr), lch(nullptr),
-                                                                      rch(nullptr), next(nullptr),
-                                                                      pre(nullptr), nodeColor(col) {}
+            RedBlackNode(const Key &k, const T &v, COLOR col = red) : lch(nullptr), rch(nullptr), record(k, v) {
+                this->setColor(col);
+            }
 
-            explicit RedBlackNode(const RedBlackNode *other) : record(other->record), nodeColor(other->nodeColor),
-                                                               parent(nullptr),
-                                                               lch(nullptr), rch(nullptr), next(nullptr),
-                                                               pre(nullptr) {}
+            explicit RedBlackNode(const RedBlackNode *other) : lch(nullptr), rch(nullptr), record(other->record) {
+                this->setColor(other->getColor());
+            }
 
             ~RedBlackNode() {
-                if (next)
-                    next->pre = pre;
-                if (pre)
-                    pre->next = next;
+                this->unlink();
             }
 
         };
@@ -56,31 +385,48 @@ namespace sjtu {
         public:
             RedBlackNode *head, *Beg, *End;
             size_t count;
+            Compare cmp;
+
+            //negative for lhs < rhs, 0 for equal and positive for lhs > rhs
+            int compareKeys(const Key &lhs, const Key &rhs) const {
+                return map_key_compare<Compare, Key>::compare(cmp, lhs, rhs);
+            }
+
+            //a tree out of the map with a black root, bh counts the black nodes on a path
+            //from root to nullptr. min and max are only tracked without CompactNode
+            class SubTree {
+            public:
+                RedBlackNode *root, *min, *max;
+                int bh;
+
+                SubTree() : root(nullptr), min(nullptr), max(nullptr), bh(0) {}
+            };
 
             //first is the smallest one in the subtree and vice versa
             pair<RedBlackNode *, RedBlackNode *>
             build_tree(RedBlackNode *&ptr, RedBlackNode *other_ptr, RedBlackNode *pre,
                        RedBlackNode *next) {
                 ptr = new RedBlackNode(other_ptr);
-                ptr->pre = pre;
-                ptr->next = next;
+                ptr->setPre(pre);
+                ptr->setNext(next);
                 pair<RedBlackNode *, RedBlackNode *> ptr_pair(ptr, ptr);
                 if (other_ptr->lch) {
                     pair<RedBlackNode *, RedBlackNode *> tmp = build_tree(ptr->lch, other_ptr->lch, pre, ptr);
-                    ptr->lch->parent = ptr;
-                    ptr->pre = tmp.second;
+                    ptr->lch->setParent(ptr);
+                    ptr->setPre(tmp.second);
                     ptr_pair.first = tmp.first;
                 }
                 if (other_ptr->rch) {
                     pair<RedBlackNode *, RedBlackNode *> tmp = build_tree(ptr->rch, other_ptr->rch, ptr, next);
-                    ptr->rch->parent = ptr;
-                    ptr->next = tmp.first;
+                    ptr->rch->setParent(ptr);
+                    ptr->setNext(tmp.first);
                     ptr_pair.second = tmp.second;
                 }
+                pull(ptr);
                 return ptr_pair;
             }
 
-            RBT(const RBT &other) : head(nullptr), Beg(nullptr), End(nullptr), count(other.count) {
+            RBT(const RBT &other) : head(nullptr), Beg(nullptr), End(nullptr), count(other.count), cmp(other.cmp) {
                 if (other.head == nullptr) return;
                 pair<RedBlackNode *, RedBlackNode *> tmp = build_tree(head, other.head, nullptr, nullptr);
                 Beg = tmp.first;
@@ -91,6 +437,7 @@ namespace sjtu {
                 if (this == &other) return *this;
                 this->Clear();
                 count = other.count;
+                cmp = other.cmp;
                 if (other.head == nullptr) return *this;
                 pair<RedBlackNode *, RedBlackNode *> tmp = build_tree(head, other.head, nullptr, nullptr);
                 Beg = tmp.first;
@@ -98,7 +445,21 @@ namespace sjtu {
                 return *this;
             }
 
-            RBT() : head(nullptr), Beg(nullptr), End(nullptr), count(0) {}
+            RBT(RBT &&other) : head(other.head), Beg(other.Beg), End(other.End), count(other.count),
+                               cmp(other.cmp) {
+                other.head = other.Beg = other.End = nullptr;
+                other.count = 0;
+            }
+
+            RBT &operator=(RBT &&other) {
+                if (this == &other) return *this;
+                Swap(head, other.head), Swap(Beg, other.Beg), Swap(End, other.End), Swap(count, other.count);
+                Swap(cmp, other.cmp);
+                return *this;
+            }
+
+            explicit RBT(const Compare &comp = Compare()) : head(nullptr), Beg(nullptr), End(nullptr), count(0),
+                                                            cmp(comp) {}
 
             ~RBT() {
                 Clear();
@@ -111,9 +472,10 @@ namespace sjtu {
             }
 
             void Clear() {
-                if (head) {
+                if (head && CompactNode) makeEmpty(head);
+                else if (head) {
                     for (RedBlackNode *ptr = Beg, *j; ptr; ptr = j) {
-                        j = ptr->next;
+                        j = ptr->getNext();
                         delete ptr;
                     }
                 }
@@ -121,6 +483,99 @@ namespace sjtu {
                 count = 0;
             }
 
+            //link ptr after End, the tree itself is not touched
+            void pushBack(RedBlackNode *ptr) {
+                ptr->setPre(End), ptr->setNext(nullptr);
+                if (End) End->setNext(ptr);
+                else Beg = ptr;
+                End = ptr, ++count;
+            }
+
+            //flatten the subtree of ptr into a list linked by rch in order, followed by rest
+            static RedBlackNode *flatten(RedBlackNode *ptr, RedBlackNode *rest) {
+                while (ptr) {
+                    ptr->rch = flatten(ptr->rch, rest);
+                    rest = ptr, ptr = ptr->lch;
+                }
+                return rest;
+            }
+
+            //build a balanced tree over the next n nodes of the rch list from cursor
+            //nodes at redDepth are red and the others are black
+            RedBlackNode *buildBalanced(RedBlackNode *&cursor, size_t n, size_t depth, size_t redDepth) {
+                if (!n) return nullptr;
+                size_t lsize = (n - 1) >> 1;
+                RedBlackNode *lch = buildBalanced(cursor, lsize, depth + 1, redDepth);
+                RedBlackNode *ptr = cursor;
+                cursor = cursor->rch;
+                ptr->lch = lch;
+                if (lch) lch->setParent(ptr);
+                ptr->rch = buildBalanced(cursor, n - 1 - lsize, depth + 1, redDepth);
+                if (ptr->rch) ptr->rch->setParent(ptr);
+                ptr->setColor((depth == redDepth) ? red : black);
+                pull(ptr);
+                return ptr;
+            }
+
+            //a balanced tree over the next n nodes of the rch list from cursor
+            SubTree buildSubTree(RedBlackNode *cursor, size_t n) {
+                size_t redDepth = 0;
+                for (size_t i = n; i > 1; i >>= 1) ++redDepth;
+                SubTree res;
+                res.root = buildBalanced(cursor, n, 0, redDepth);
+                if (!res.root) return res;
+                res.root->setParent(nullptr);
+                res.bh = (res.root->getColor() == red) ? 1 : (int) redDepth;
+                res.root->setColor(black);
+                return res;
+            }
+
+            //rebuild the whole tree followed by the rch list from tail in O(n)
+            void rebuild(RedBlackNode *tail) {
+                head = buildSubTree(flatten(head, tail), count).root;
+            }
+
+            //elements greater than End are chained in order, built into a tree and joined
+            //to the old one, the rest of the range is inserted one by one from the first
+            //out-of-order element
+            template<class InputIterator>
+            void appendSorted(InputIterator first, InputIterator last) {
+                SubTree old = whole();
+                size_t oldCount = count;
+                RedBlackNode *chain = nullptr, *chainEnd = nullptr, *oldEnd = End;
+                try {
+                    for (; first != last; ++first) {
+                        if (End) {
+                            int res = compareKeys((*first).first, End->record.first);
+                            if (res < 0) break;
+                            if (res == 0) continue;
+                        }
+                        RedBlackNode *ptr = new RedBlackNode((*first).first, (*first).second);
+                        if (chainEnd) chainEnd->rch = ptr;
+                        else chain = ptr;
+                        chainEnd = ptr;
+                        pushBack(ptr);
+                    }
+                } catch (...) {
+                    //the chain is in no tree yet, so Clear() would not find it
+                    for (RedBlackNode *ptr = chain, *j; ptr; ptr = j) {
+                        j = ptr->rch;
+                        dispose(ptr);
+                    }
+                    End = oldEnd, count = oldCount;
+                    if (End) End->setNext(nullptr);
+                    else Beg = nullptr;
+                    throw;
+                }
+                if (chain && !old.root) rebuild(chain);
+                else if (chain) {
+                    SubTree rest = buildSubTree(chain->rch, count - oldCount - 1);
+                    if (!CompactNode) rest.min = chain->getNext(), rest.max = End;
+                    adopt(join(old, chain, rest), count);
+                }
+                for (; first != last; ++first) insert((*first).first, (*first).second);
+            }
+
             void makeEmpty(RedBlackNode *ptr) {
                 if (ptr->rch)
                     makeEmpty(ptr->rch);
@@ -129,92 +584,135 @@ namespace sjtu {
                 delete ptr;
             }
 
-            void Del(RedBlackNode *ptr) {
-                if (ptr == Beg) Beg = ptr->next;
-                if (ptr == End) End = ptr->pre;
-                delete ptr;
+            static size_t sizeOf(const RedBlackNode *ptr) {
+                return ptr ? ptr->getSize() : 0;
+            }
+
+            static const bool Augmented = OrderStatistic || map_subtree_summary<Monoid>::enabled;
+
+            //recompute the augmented data of ptr from its children
+            void pull(RedBlackNode *ptr) {
+                ptr->setSize(sizeOf(ptr->lch) + sizeOf(ptr->rch) + 1);
+                ptr->summarize(ptr->record.first, ptr->record.second, ptr->lch, ptr->rch);
+            }
+
+            //recompute the augmented data from ptr up to the root, after a leaf is linked or
+            //a node is spliced out below ptr. nodes off the path are kept right by the rotations
+            void pullPath(RedBlackNode *ptr) {
+                if (!Augmented) return;
+                for (; ptr; ptr = ptr->getParent()) pull(ptr);
+            }
+
+            //ptr has one child at most and is about to be spliced out of the tree
+            void retire(RedBlackNode *ptr) {
+                if (ptr == Beg) Beg = ptr->getNext();
+                if (ptr == End) End = ptr->getPre();
             }
 
             void singleRotate(RedBlackNode *ptr) {
-                RedBlackNode *P = ptr->parent;
+                RedBlackNode *P = ptr->getParent();
                 if (P == nullptr) return;
                 bool flag_ptr = isLeftChild(ptr);
-                if (P == head) {
-                    head = ptr;
-                    ptr->parent = nullptr;
+                if (P->getParent() == nullptr) {
+                    //P may be the root of a detached tree during join
+                    if (P == head) head = ptr;
+                    ptr->setParent(nullptr);
                 } else {
-                    if (isLeftChild(P)) P->parent->lch = ptr;
-                    else P->parent->rch = ptr;
-                    ptr->parent = P->parent;
+                    if (isLeftChild(P)) P->getParent()->lch = ptr;
+                    else P->getParent()->rch = ptr;
+                    ptr->setParent(P->getParent());
                 }
-                P->parent = ptr;
+                P->setParent(ptr);
                 if (flag_ptr) {
-                    if (ptr->rch) ptr->rch->parent = P;
+                    if (ptr->rch) ptr->rch->setParent(P);
                     P->lch = ptr->rch, ptr->rch = P;
                 } else {
-                    if (ptr->lch) ptr->lch->parent = P;
+                    if (ptr->lch) ptr->lch->setParent(P);
                     P->rch = ptr->lch, ptr->lch = P;
                 }
+                pull(P), pull(ptr);
             }
 
             void rotate(RedBlackNode *ptr, RedBlackNode *P, RedBlackNode *G, int dye_pattern = 0) {
                 //LL & RR
                 if (P->lch == ptr && G->lch == P || P->rch == ptr && G->rch == P) {
                     singleRotate(P);
-                    if (dye_pattern == 0) P->nodeColor = black, G->nodeColor = red;
-                    else if (dye_pattern == 1) ptr->nodeColor = black, G->nodeColor = black, P->nodeColor = red;
+                    if (dye_pattern == 0) P->setColor(black), G->setColor(red);
+                    else if (dye_pattern == 1) ptr->setColor(black), G->setColor(black), P->setColor(red);
                 }
                 //LR & RL
                 if (P->rch == ptr && G->lch == P || P->lch == ptr && G->rch == P) {
                     singleRotate(ptr), singleRotate(ptr);
-                    if (dye_pattern == 0) ptr->nodeColor = black, G->nodeColor = red;
-                    else if (dye_pattern == 1) ptr->nodeColor = red, G->nodeColor = black, P->nodeColor = black;
+                    if (dye_pattern == 0) ptr->setColor(black), G->setColor(red);
+                    else if (dye_pattern == 1) ptr->setColor(red), G->setColor(black), P->setColor(black);
                 }
             }
 
-            pointer insert(const Key &key, const T &value = T()) {
-                Compare cmp;
+            static RedBlackNode *makeNode(const Key &key) {
+                return new RedBlackNode(key, T());
+            }
+
+            static RedBlackNode *makeNode(const Key &key, const T &value) {
+                return new RedBlackNode(key, value);
+            }
+
+            template<class... Args>
+            static RedBlackNode *makeNode(const Key &key, Args &&... args) {
+                return new RedBlackNode(key, T(std::forward<Args>(args)...));
+            }
+
+            //the value is constructed from args only when key does not exist
+            template<class... Args>
+            pointer insert(const Key &key, Args &&... args) {
                 if (!head) {
-                    head = new RedBlackNode(key, value, black), Beg = End = head, ++count;
+                    head = makeNode(key, std::forward<Args>(args)...), Beg = End = head, ++count;
+                    head->setColor(black);
+                    pull(head);
                     return pointer(head, true);
                 }
+                //keys beyond End are appended without a descent
+                if (compareKeys(key, End->record.first) > 0)
+                    return pointer(linkBetween(End, nullptr, makeNode(key, std::forward<Args>(args)...)), true);
                 RedBlackNode *ptr = head, *child, *P, *G, *pre, *next;
                 pre = next = nullptr;
                 while (1) {
+                    //rotations below keep ptr itself, so one comparison serves the whole level
+                    int res = compareKeys(key, ptr->record.first);
                     //have existed?
-                    if (!(cmp(ptr->record.first, key) || cmp(key, ptr->record.first))) return pointer(ptr, false);
+                    if (res == 0) return pointer(ptr, false);
                     //avoid red uncle node
                     if (ptr->rch && ptr->lch)
-                        if (ptr->rch->nodeColor == red && ptr->lch->nodeColor == red) {
-                            ptr->rch->nodeColor = ptr->lch->nodeColor = black;
-                            P = ptr->parent;
+                        if (ptr->rch->getColor() == red && ptr->lch->getColor() == red) {
+                            ptr->rch->setColor(black), ptr->lch->setColor(black);
+                            P = ptr->getParent();
                             if (P) {
-                                G = P->parent;
-                                ptr->nodeColor = red;
-                                if (P->nodeColor == red) {
+                                G = P->getParent();
+                                ptr->setColor(red);
+                                if (P->getColor() == red) {
                                     //rotate
                                     rotate(ptr, P, G);
                                 }
                             }
                         }
                     //insert into left tree
-                    if (cmp(key, ptr->record.first)) {
+                    if (res < 0) {
                         next = ptr;
                         if (ptr->lch) {
                             ptr = ptr->lch;
                         }//insert
                         else {
-                            ptr->lch = new RedBlackNode(key, value);
+                            ptr->lch = makeNode(key, std::forward<Args>(args)...);
                             child = ptr->lch;
-                            child->pre = pre;
-                            child->next = next;
-                            if (pre) pre->next = child;
+                            child->setPre(pre);
+                            child->setNext(next);
+                            if (pre) pre->setNext(child);
                             else Beg = child;
-                            if (next) next->pre = child;
+                            if (next) next->setPre(child);
                             else End = child;
-                            child->parent = ptr;
-                            if (ptr->nodeColor == red) {
-                                rotate(child, ptr, ptr->parent);
+                            child->setParent(ptr);
+                            pullPath(child);
+                            if (ptr->getColor() == red) {
+                                rotate(child, ptr, ptr->getParent());
                             }
                             ++count;
                             return pointer(child, true);
@@ -226,17 +724,18 @@ namespace sjtu {
                             ptr = ptr->rch;
                         }//insert
                         else {
-                            ptr->rch = new RedBlackNode(key, value);
+                            ptr->rch = makeNode(key, std::forward<Args>(args)...);
                             child = ptr->rch;
-                            child->pre = pre;
-                            child->next = next;
-                            if (pre) pre->next = child;
+                            child->setPre(pre);
+                            child->setNext(next);
+                            if (pre) pre->setNext(child);
                             else Beg = child;
-                            if (next) next->pre = child;
+                            if (next) next->setPre(child);
                             else End = child;
-                            child->parent = ptr;
-                            if (ptr->nodeColor == red) {
-                                rotate(child, ptr, ptr->parent);
+                            child->setParent(ptr);
+                            pullPath(child);
+                            if (ptr->getColor() == red) {
+                                rotate(child, ptr, ptr->getParent());
                             }
                             ++count;
                             return pointer(child, true);
@@ -245,61 +744,104 @@ namespace sjtu {
                 }
             }
 
+            //ptr belongs between the neighbours pre and next (nullptr for none),
+            //link it as a leaf there and fix the colors bottom-up
+            RedBlackNode *linkBetween(RedBlackNode *pre, RedBlackNode *next, RedBlackNode *ptr) {
+                //pre is the rightmost node under next->lch if there is one
+                if (next && !next->lch) next->lch = ptr, ptr->setParent(next);
+                else pre->rch = ptr, ptr->setParent(pre);
+                ptr->setPre(pre), ptr->setNext(next);
+                if (pre) pre->setNext(ptr);
+                else Beg = ptr;
+                if (next) next->setPre(ptr);
+                else End = ptr;
+                ++count;
+                pullPath(ptr);
+                insertFixup(ptr, head);
+                head->setColor(black);
+                return ptr;
+            }
+
+            //insert right before next (nullptr for the end) when the threads confirm the position,
+            //which costs two comparisons, and from head otherwise
+            template<class... Args>
+            pointer insertHint(RedBlackNode *next, const Key &key, Args &&... args) {
+                if (!head) return insert(key, std::forward<Args>(args)...);
+                RedBlackNode *pre = next ? next->getPre() : End;
+                int res;
+                if (next) {
+                    res = compareKeys(key, next->record.first);
+                    if (res == 0) return pointer(next, false);
+                    if (res > 0) return insert(key, std::forward<Args>(args)...);
+                }
+                if (pre) {
+                    res = compareKeys(key, pre->record.first);
+                    if (res == 0) return pointer(pre, false);
+                    if (res < 0) return insert(key, std::forward<Args>(args)...);
+                }
+                return pointer(linkBetween(pre, next, makeNode(key, std::forward<Args>(args)...)), true);
+            }
+
             void SwapTwoRBNode(RedBlackNode *a, RedBlackNode *b) {
-                if (a->parent == b) {
+                if (a->getParent() == b) {
                     SwapTwoRBNode(b, a);
                     return;
                 }
                 RedBlackNode *BP, *BR, *BL;
-                Swap(a->nodeColor, b->nodeColor);
-                bool A_lch, B_lch;
-                BP = b->parent, BL = b->lch, BR = b->rch;
-                if (a->parent) A_lch = isLeftChild(a);
-                if (BP) B_lch = isLeftChild(b);
+                int tmpColor = a->getColor();
+                a->setColor(b->getColor()), b->setColor(tmpColor);
+                //sizes go with the positions, while the summaries from a down to b stay stale
+                //until the caller splices a out and pulls the path
+                if (OrderStatistic) {
+                    size_t tmp = a->getSize();
+                    a->setSize(b->getSize()), b->setSize(tmp);
+                }
+                BP = b->getParent(), BL = b->lch, BR = b->rch;
+                bool A_lch = a->getParent() && isLeftChild(a), B_lch = BP && isLeftChild(b);
                 if (BP == a) {
-                    if (a->parent) {
-                        if (A_lch) a->parent->lch = b;
-                        else a->parent->rch = b;
+                    if (a->getParent()) {
+                        if (A_lch) a->getParent()->lch = b;
+                        else a->getParent()->rch = b;
                     } else head = b;
-                    b->parent = a->parent, a->parent = b;
+                    b->setParent(a->getParent()), a->setParent(b);
                     if (B_lch) {
                         b->lch = a, b->rch = a->rch;
-                        if (a->rch) a->rch->parent = b;
+                        if (a->rch) a->rch->setParent(b);
                     } else {
                         b->rch = a, b->lch = a->lch;
-                        if (a->lch) a->lch->parent = b;
+                        if (a->lch) a->lch->setParent(b);
                     }
-                    if (BL) BL->parent = a;
-                    if (BR) BR->parent = a;
+                    if (BL) BL->setParent(a);
+                    if (BR) BR->setParent(a);
                     a->lch = BL, a->rch = BR;
                 } else {
                     if (BP) {
                         if (B_lch) BP->lch = a;
                         else BP->rch = a;
                     } else head = a;
-                    b->parent = a->parent;
-                    if (a->parent) {
-                        if (A_lch) a->parent->lch = b;
-                        else a->parent->rch = b;
+                    b->setParent(a->getParent());
+                    if (a->getParent()) {
+                        if (A_lch) a->getParent()->lch = b;
+                        else a->getParent()->rch = b;
                     } else head = b;
-                    a->parent = BP;
-                    if (BL) BL->parent = a;
-                    if (BR) BR->parent = a;
+                    a->setParent(BP);
+                    if (BL) BL->setParent(a);
+                    if (BR) BR->setParent(a);
                     b->lch = a->lch, b->rch = a->rch;
-                    if (a->lch) a->lch->parent = b;
-                    if (a->rch) a->rch->parent = b;
+                    if (a->lch) a->lch->setParent(b);
+                    if (a->rch) a->rch->setParent(b);
                     a->lch = BL, a->rch = BR;
                 }
             }
 
             bool isLeftChild(RedBlackNode *ptr) {
-                return (ptr->parent->lch == ptr);
+                return (ptr->getParent()->lch == ptr);
             }
 
             RedBlackNode *getSibling(RedBlackNode *ptr) {
-                if (ptr->parent) {
-                    if (isLeftChild(ptr)) return ptr->parent->rch;
-                    else return ptr->parent->lch;
+                if (ptr->getParent()) {
+                    if (isLeftChild(ptr)) return ptr->getParent()->rch;
+                    else return ptr->getParent()->lch;
                 }
                 return nullptr;
             }
@@ -308,143 +850,687 @@ namespace sjtu {
                 RedBlackNode *tmp = getSibling(ptr);
                 if (tmp) {
                     if (isLeftChild(ptr)) {
-                        if (tmp->rch && tmp->rch->nodeColor == red) return tmp->rch;
-                        if (tmp->lch && tmp->lch->nodeColor == red) return tmp->lch;
+                        if (tmp->rch && tmp->rch->getColor() == red) return tmp->rch;
+                        if (tmp->lch && tmp->lch->getColor() == red) return tmp->lch;
                     } else {
-                        if (tmp->lch && tmp->lch->nodeColor == red) return tmp->lch;
-                        if (tmp->rch && tmp->rch->nodeColor == red) return tmp->rch;
+                        if (tmp->lch && tmp->lch->getColor() == red) return tmp->lch;
+                        if (tmp->rch && tmp->rch->getColor() == red) return tmp->rch;
                     }
                 }
                 return nullptr;
             }
 
-            void Delete(const Key &key, bool flag = false) {
-                Compare cmp;
+            //false for not found
+            bool Delete(const Key &key, bool flag = false) {
+                bool found = false;
                 RedBlackNode *ptr = head, *child, *P, *G, *R, *Sib;
                 while (1) {
                     //make current node red
                     if (ptr == nullptr) break;
-                    if (ptr->nodeColor == black) {
-                        if ((ptr->lch == nullptr || ptr->lch->nodeColor == black) &&
-                            (ptr->rch == nullptr || ptr->rch->nodeColor == black)) {
+                    int res = compareKeys(key, ptr->record.first);
+                    if (ptr->getColor() == black) {
+                        if ((ptr->lch == nullptr || ptr->lch->getColor() == black) &&
+                            (ptr->rch == nullptr || ptr->rch->getColor() == black)) {
                             R = getSiblingsRedChild(ptr);
                             Sib = getSibling(ptr);
                             if (R == nullptr) {
-                                if (ptr->parent) ptr->parent->nodeColor = black;
-                                ptr->nodeColor = red;
-                                if (Sib) Sib->nodeColor = red;
+                                if (ptr->getParent()) ptr->getParent()->setColor(black);
+                                ptr->setColor(red);
+                                if (Sib) Sib->setColor(red);
                             } else {
-                                rotate(R, Sib, ptr->parent, 1);
-                                ptr->nodeColor = red;
+                                rotate(R, Sib, ptr->getParent(), 1);
+                                ptr->setColor(red);
                             }
                         } else {
-                            if (!cmp(key, ptr->record.first) && !cmp(ptr->record.first, key)) {
+                            if (res == 0) {
                                 if (flag)
                                     flag = 1;
                                 if (ptr->rch == nullptr || ptr->lch == nullptr) {
                                     if (ptr->rch != nullptr) child = ptr->rch;
                                     else child = ptr->lch;
                                     singleRotate(child);
-                                    child->nodeColor = black;
-                                    ptr->nodeColor = red;
+                                    child->setColor(black);
+                                    ptr->setColor(red);
                                 } else {
-                                    P = ptr->next, Sib = ptr->lch;
-                                    SwapTwoRBNode(ptr, ptr->next);
-                                    if (P->rch->nodeColor == black) {
+                                    P = ptr->getNext(), Sib = ptr->lch;
+                                    SwapTwoRBNode(ptr, ptr->getNext());
+                                    if (P->rch->getColor() == black) {
                                         singleRotate(Sib);
-                                        Sib->nodeColor = black;
-                                        P->nodeColor = red;
+                                        Sib->setColor(black);
+                                        P->setColor(red);
                                     }
                                     ptr = P->rch;
                                 }
                                 continue;
-                            } else if (cmp(key, ptr->record.first)) {
+                            } else if (res < 0) {
                                 P = ptr, Sib = P->rch, ptr = ptr->lch;
-                                if (ptr && ptr->nodeColor == black) {
-                                    singleRotate(Sib), P->nodeColor = red, Sib->nodeColor = black;
+                                if (ptr && ptr->getColor() == black) {
+                                    singleRotate(Sib), P->setColor(red), Sib->setColor(black);
                                 }
                                 continue;
                             } else {
                                 P = ptr, Sib = P->lch, ptr = ptr->rch;
-                                if (ptr && ptr->nodeColor == black) {
-                                    singleRotate(Sib), P->nodeColor = red, Sib->nodeColor = black;
+                                if (ptr && ptr->getColor() == black) {
+                                    singleRotate(Sib), P->setColor(red), Sib->setColor(black);
                                 }
                                 continue;
                             }
                         }
                     }
                     //delete the node
-                    if (!cmp(key, ptr->record.first) && !cmp(ptr->record.first, key)) {
+                    if (res == 0) {
                         //leaf or has only one child
                         if (ptr->rch == nullptr) {
+                            retire(ptr);
+                            P = ptr->getParent();
                             //has the left child
                             if (ptr->lch != nullptr) {
-                                if (ptr->parent) {
-                                    if (isLeftChild(ptr)) ptr->parent->lch = ptr->lch;
-                                    else ptr->parent->rch = ptr->lch;
-                                    ptr->lch->parent = ptr->parent;
+                                if (ptr->getParent()) {
+                                    if (isLeftChild(ptr)) ptr->getParent()->lch = ptr->lch;
+                                    else ptr->getParent()->rch = ptr->lch;
+                                    ptr->lch->setParent(ptr->getParent());
                                 } else {
                                     head = ptr->lch;
-                                    ptr->lch->parent = nullptr;
+                                    ptr->lch->setParent(nullptr);
                                 }
                             }//does not have a child
                             else {
-                                if (ptr->parent) {
-                                    if (isLeftChild(ptr)) ptr->parent->lch = nullptr;
-                                    else ptr->parent->rch = nullptr;
+                                if (ptr->getParent()) {
+                                    if (isLeftChild(ptr)) ptr->getParent()->lch = nullptr;
+                                    else ptr->getParent()->rch = nullptr;
                                 } else head = nullptr;
                             }
-                            Del(ptr);
+                            pullPath(P);
+                            delete ptr;
                             --count;
+                            found = true;
                             break;
                         } else {
                             //has the right child
                             if (ptr->lch == nullptr) {
-                                if (ptr->parent) {
-                                    if (isLeftChild(ptr)) ptr->parent->lch = ptr->rch;
-                                    else ptr->parent->rch = ptr->rch;
-                                    ptr->rch->parent = ptr->parent;
+                                retire(ptr);
+                                P = ptr->getParent();
+                                if (ptr->getParent()) {
+                                    if (isLeftChild(ptr)) ptr->getParent()->lch = ptr->rch;
+                                    else ptr->getParent()->rch = ptr->rch;
+                                    ptr->rch->setParent(ptr->getParent());
                                 } else {
                                     head = ptr->rch;
-                                    ptr->rch->parent = nullptr;
+                                    ptr->rch->setParent(nullptr);
                                 }
-                                Del(ptr);
+                                pullPath(P);
+                                delete ptr;
                                 --count;
+                                found = true;
                                 break;
                             }//has the right and left child
                             else {
-                                child = ptr->next;
-                                SwapTwoRBNode(ptr, ptr->next);
+                                child = ptr->getNext();
+                                SwapTwoRBNode(ptr, ptr->getNext());
                                 ptr = child->rch;
                             }
                         }
-                    } else ptr = cmp(key, ptr->record.first) ? ptr->lch : ptr->rch;
+                    } else ptr = (res < 0) ? ptr->lch : ptr->rch;
                 }
                 //adjust the root color
-                if (head && head->nodeColor == red)
-                    head->nodeColor = black;
+                if (head && head->getColor() == red)
+                    head->setColor(black);
+                return found;
+            }
+
+            static bool isBlack(const RedBlackNode *ptr) {
+                return ptr == nullptr || ptr->getColor() == black;
+            }
+
+            //remove ptr bottom-up without searching from head
+            void Erase(RedBlackNode *ptr) {
+                if (ptr->lch && ptr->rch) SwapTwoRBNode(ptr, ptr->getNext());
+                //ptr has one child at most now
+                RedBlackNode *child = ptr->lch ? ptr->lch : ptr->rch, *P = ptr->getParent();
+                bool leftSide = P && isLeftChild(ptr);
+                retire(ptr);
+                if (child) child->setParent(P);
+                if (!P) head = child;
+                else if (leftSide) P->lch = child;
+                else P->rch = child;
+                pullPath(P);
+                if (ptr->getColor() == black) {
+                    if (child) child->setColor(black);
+                    else if (P) eraseFixup(P, leftSide);
+                }
+                delete ptr;
+                --count;
+            }
+
+            //the subtree on one side of P is short of one black node
+            void eraseFixup(RedBlackNode *P, bool leftSide) {
+                while (P) {
+                    RedBlackNode *Sib = leftSide ? P->rch : P->lch;
+                    if (Sib->getColor() == red) {
+                        singleRotate(Sib);
+                        Sib->setColor(black), P->setColor(red);
+                        Sib = leftSide ? P->rch : P->lch;
+                    }
+                    RedBlackNode *nearChild = leftSide ? Sib->lch : Sib->rch;
+                    RedBlackNode *farChild = leftSide ? Sib->rch : Sib->lch;
+                    if (isBlack(nearChild) && isBlack(farChild)) {
+                        Sib->setColor(red);
+                        if (P->getColor() == red) {
+                            P->setColor(black);
+                            return;
+                        }
+                        //P is short of one black node now
+                        if (P->getParent()) leftSide = isLeftChild(P);
+                        P = P->getParent();
+                        continue;
+                    }
+                    if (isBlack(farChild)) {
+                        singleRotate(nearChild);
+                        nearChild->setColor(black), Sib->setColor(red);
+                        farChild = Sib, Sib = nearChild;
+                    }
+                    singleRotate(Sib);
+                    Sib->setColor(P->getColor());
+                    P->setColor(black), farChild->setColor(black);
+                    return;
+                }
+            }
+
+            //the red parent of ptr is fixed bottom-up, return the root of the tree
+            RedBlackNode *insertFixup(RedBlackNode *ptr, RedBlackNode *root) {
+                RedBlackNode *P, *G, *U;
+                while ((P = ptr->getParent()) && P->getColor() == red) {
+                    G = P->getParent();
+                    U = (G->lch == P) ? G->rch : G->lch;
+                    if (!isBlack(U)) {
+                        P->setColor(black), U->setColor(black), G->setColor(red);
+                        ptr = G;
+                        continue;
+                    }
+                    if (G == root) root = ((P->lch == ptr) == (G->lch == P)) ? P : ptr;
+                    rotate(ptr, P, G);
+                    break;
+                }
+                return root;
+            }
+
+            static RedBlackNode *leftmost(RedBlackNode *ptr) {
+                if (ptr) while (ptr->lch) ptr = ptr->lch;
+                return ptr;
+            }
+
+            static RedBlackNode *rightmost(RedBlackNode *ptr) {
+                if (ptr) while (ptr->rch) ptr = ptr->rch;
+                return ptr;
+            }
+
+            SubTree whole() const {
+                SubTree res;
+                res.root = head, res.min = Beg, res.max = End;
+                for (RedBlackNode *ptr = head; ptr; ptr = ptr->lch)
+                    if (ptr->getColor() == black) ++res.bh;
+                return res;
+            }
+
+            //take t as the whole tree of the map
+            void adopt(const SubTree &t, size_t n) {
+                head = t.root, count = n;
+                if (CompactNode) Beg = leftmost(head), End = rightmost(head);
+                else Beg = t.min, End = t.max;
+                if (Beg) Beg->setPre(nullptr), End->setNext(nullptr);
+            }
+
+            //cut the subtree of t.root->lch out as a tree, the threads inside it are kept
+            static SubTree leftPart(const SubTree &t) {
+                SubTree res;
+                res.root = t.root->lch;
+                if (!res.root) return res;
+                res.bh = t.bh - 1;
+                if (!CompactNode) res.min = t.min, res.max = t.root->getPre();
+                res.root->setParent(nullptr);
+                if (res.root->getColor() == red) res.root->setColor(black), ++res.bh;
+                return res;
+            }
+
+            static SubTree rightPart(const SubTree &t) {
+                SubTree res;
+                res.root = t.root->rch;
+                if (!res.root) return res;
+                res.bh = t.bh - 1;
+                if (!CompactNode) res.min = t.root->getNext(), res.max = t.max;
+                res.root->setParent(nullptr);
+                if (res.root->getColor() == red) res.root->setColor(black), ++res.bh;
+                return res;
+            }
+
+            static void attach(RedBlackNode *ptr, RedBlackNode *lch, RedBlackNode *rch) {
+                ptr->lch = lch, ptr->rch = rch;
+                if (lch) lch->setParent(ptr);
+                if (rch) rch->setParent(ptr);
+            }
+
+            //keys in l < k < keys in r, O(|l.bh - r.bh| + 1) plus the path to the root with OrderStatistic
+            SubTree join(const SubTree &l, RedBlackNode *k, const SubTree &r) {
+                if (!CompactNode) {
+                    k->setPre(l.max), k->setNext(r.min);
+                    if (l.max) l.max->setNext(k);
+                    if (r.min) r.min->setPre(k);
+                }
+                SubTree res;
+                res.min = l.root ? l.min : k;
+                res.max = r.root ? r.max : k;
+                k->setParent(nullptr);
+                if (l.bh == r.bh) {
+                    k->setColor(black);
+                    attach(k, l.root, r.root);
+                    pull(k);
+                    res.root = k, res.bh = l.bh + 1;
+                    return res;
+                }
+                //walk down the spine of the higher tree to a black node as high as the other tree
+                bool leftHigher = l.bh > r.bh;
+                RedBlackNode *P = nullptr, *ptr = leftHigher ? l.root : r.root;
+                int h = leftHigher ? l.bh : r.bh, target = leftHigher ? r.bh : l.bh;
+                while (!(isBlack(ptr) && h == target)) {
+                    if (ptr->getColor() == black) --h;
+                    P = ptr, ptr = leftHigher ? ptr->rch : ptr->lch;
+                }
+                k->setColor(red);
+                if (leftHigher) attach(k, ptr, r.root), P->rch = k;
+                else attach(k, l.root, ptr), P->lch = k;
+                k->setParent(P);
+                pull(k);
+                pullPath(P);
+                res.root = insertFixup(k, leftHigher ? l.root : r.root);
+                res.bh = leftHigher ? l.bh : r.bh;
+                if (res.root->getColor() == red) res.root->setColor(black), ++res.bh;
+                return res;
+            }
+
+            //split t into keys less than key, the node of key (nullptr for none) and keys greater than key
+            void split(const SubTree &t, const Key &key, SubTree &l, RedBlackNode *&mid, SubTree &r) {
+                if (!t.root) {
+                    l = r = SubTree(), mid = nullptr;
+                    return;
+                }
+                RedBlackNode *ptr = t.root;
+                SubTree lt = leftPart(t), rt = rightPart(t), tmp;
+                int res = compareKeys(key, ptr->record.first);
+                if (res == 0) l = lt, mid = ptr, r = rt;
+                else if (res < 0) split(lt, key, l, mid, tmp), r = join(tmp, ptr, rt);
+                else split(rt, key, tmp, mid, r), l = join(lt, ptr, tmp);
+            }
+
+            //split the largest node off t and leave the others in rest
+            RedBlackNode *splitLast(const SubTree &t, SubTree &rest) {
+                RedBlackNode *ptr = t.root;
+                if (!ptr->rch) {
+                    rest = leftPart(t);
+                    return ptr;
+                }
+                SubTree tmp;
+                RedBlackNode *last = splitLast(rightPart(t), tmp);
+                rest = join(leftPart(t), ptr, tmp);
+                return last;
+            }
+
+            //keys in l < keys in r
+            SubTree join(const SubTree &l, const SubTree &r) {
+                if (!l.root) return r;
+                if (!r.root) return l;
+                SubTree rest;
+                RedBlackNode *last = splitLast(l, rest);
+                return join(rest, last, r);
+            }
+
+            //the threads are cut first, the neighbours may have gone
+            static void dispose(RedBlackNode *ptr) {
+                ptr->setPre(nullptr), ptr->setNext(nullptr);
+                delete ptr;
+            }
+
+            static size_t destroy(RedBlackNode *ptr) {
+                if (!ptr) return 0;
+                size_t res = destroy(ptr->lch) + destroy(ptr->rch) + 1;
+                dispose(ptr);
+                return res;
+            }
+
+            //subtrees lower than this are not worth a fork
+            static const int forkGrain = 12;
+
+            template<class Fork, class F, class G>
+            static void fork2(const Fork &fork, int bh, F f, G g) {
+                if (bh >= forkGrain) fork(f, g);
+                else f(), g();
+            }
+
+            //the node of a in the middle is kept on equal keys if keepA, the node of b otherwise.
+            //removed counts the nodes deleted
+            template<class Fork>
+            SubTree unite(const SubTree &a, const SubTree &b, bool keepA, size_t &removed, const Fork &fork) {
+                if (!a.root) return b;
+                if (!b.root) return a;
+                RedBlackNode *ptr = a.root, *dup;
+                SubTree al = leftPart(a), ar = rightPart(a), bl, br, l, r;
+                split(b, ptr->record.first, bl, dup, br);
+                if (dup) {
+                    ++removed;
+                    if (keepA) dispose(dup);
+                    else dispose(ptr), ptr = dup;
+                }
+                size_t removedRight = 0;
+                fork2(fork, a.bh, [&] { l = unite(al, bl, keepA, removed, fork); },
+                      [&] { r = unite(ar, br, keepA, removedRight, fork); });
+                removed += removedRight;
+                return join(l, ptr, r);
+            }
+
+            template<class Fork>
+            SubTree intersect(const SubTree &a, const SubTree &b, bool keepA, size_t &removed, const Fork &fork) {
+                if (!a.root || !b.root) {
+                    removed += destroy(a.root) + destroy(b.root);
+                    return SubTree();
+                }
+                RedBlackNode *ptr = a.root, *dup;
+                SubTree al = leftPart(a), ar = rightPart(a), bl, br, l, r;
+                split(b, ptr->record.first, bl, dup, br);
+                size_t removedRight = 0;
+                fork2(fork, a.bh, [&] { l = intersect(al, bl, keepA, removed, fork); },
+                      [&] { r = intersect(ar, br, keepA, removedRight, fork); });
+                removed += removedRight + 1;
+                if (!dup) {
+                    dispose(ptr);
+                    return join(l, r);
+                }
+                if (keepA) dispose(dup);
+                else dispose(ptr), ptr = dup;
+                return join(l, ptr, r);
+            }
+
+            //keys of a that are not in b, following the structure of b
+            template<class Fork>
+            SubTree subtract(const SubTree &a, const SubTree &b, size_t &removed, const Fork &fork) {
+                if (!b.root) return a;
+                if (!a.root) {
+                    removed += destroy(b.root);
+                    return a;
+                }
+                RedBlackNode *ptr = b.root, *dup;
+                SubTree bl = leftPart(b), br = rightPart(b), al, ar, l, r;
+                split(a, ptr->record.first, al, dup, ar);
+                if (dup) dispose(dup), ++removed;
+                dispose(ptr), ++removed;
+                size_t removedRight = 0;
+                fork2(fork, b.bh, [&] { l = subtract(al, bl, removed, fork); },
+                      [&] { r = subtract(ar, br, removedRight, fork); });
+                removed += removedRight;
+                return join(l, r);
+            }
+
+            //op is one of unite, intersect and subtract, other is left empty
+            template<class Fork>
+            void setOperation(RBT &other, int op, const Fork &fork) {
+                size_t total = count + other.count, removed = 0;
+                //the smaller tree is walked and the larger one is split
+                bool thisSmaller = count <= other.count;
+                SubTree mine = whole(), theirs = other.whole(), res;
+                head = Beg = End = nullptr;
+                other.head = other.Beg = other.End = nullptr, other.count = 0;
+                SubTree &small = thisSmaller ? mine : theirs, &large = thisSmaller ? theirs : mine;
+                if (op == 0) res = unite(small, large, thisSmaller, removed, fork);
+                else if (op == 1) res = intersect(small, large, thisSmaller, removed, fork);
+                else res = subtract(mine, theirs, removed, fork);
+                adopt(res, total - removed);
+            }
+
+            //keys not less than key are moved into right
+            void splitOff(const Key &key, RBT &right) {
+                SubTree l, r;
+                RedBlackNode *mid;
+                split(whole(), key, l, mid, r);
+                if (mid) r = join(SubTree(), mid, r);
+                size_t total = count;
+                adopt(l, 0), right.adopt(r, 0);
+                //count the smaller part by walking both at once
+                size_t walked = 0;
+                RedBlackNode *p = Beg, *q = right.Beg;
+                while (p && q) {
+                    ++walked;
+                    p = (p == End) ? nullptr : p->getNext();
+                    q = (q == right.End) ? nullptr : q->getNext();
+                }
+                count = p ? total - walked : walked;
+                right.count = total - count;
             }
 
             //false for not found
             pointer get(const Key &key) const {
-                Compare cmp;
                 RedBlackNode *ptr = head;
                 while (ptr) {
-                    if (!(cmp(ptr->record.first, key) || cmp(key, ptr->record.first))) return pointer(ptr, true);
-                    if (cmp(key, ptr->record.first)) ptr = ptr->lch;
+                    int res = compareKeys(key, ptr->record.first);
+                    if (res == 0) return pointer(ptr, true);
+                    if (res < 0) ptr = ptr->lch;
                     else ptr = ptr->rch;
                 }
                 return pointer(nullptr, false);
             }
+
+            //hint the cache to load ptr ahead of the comparison on it
+            static void prefetch(const RedBlackNode *ptr) {
+#if defined(__GNUC__)
+                __builtin_prefetch(ptr);
+#endif
+            }
+
+            //lookups advanced one level at a time in groups
+            static const size_t batchWidth = 16;
+
+            //out[i] is the node of keys[i], nullptr for not found.
+            //a group of lookups walks down together, so the misses on the next level overlap
+            void getBatch(const Key *keys, size_t n, RedBlackNode **out) const {
+                for (size_t base = 0; base < n; base += batchWidth) {
+                    size_t width = (n - base < batchWidth) ? n - base : batchWidth, active = width;
+                    RedBlackNode *cursor[batchWidth];
+                    for (size_t i = 0; i < width; ++i) cursor[i] = head, out[base + i] = nullptr;
+                    while (active) {
+                        active = 0;
+                        for (size_t i = 0; i < width; ++i) {
+                            RedBlackNode *ptr = cursor[i];
+                            if (!ptr) continue;
+                            int res = compareKeys(keys[base + i], ptr->record.first);
+                            if (res == 0) {
+                                out[base + i] = ptr, cursor[i] = nullptr;
+                                continue;
+                            }
+                            cursor[i] = ptr = (res < 0) ? ptr->lch : ptr->rch;
+                            if (ptr) prefetch(ptr), ++active;
+                        }
+                    }
+                }
+            }
+
+            typedef typename map_subtree_summary<Monoid>::summary_type summary_type;
+
+            static summary_type summaryOf(const RedBlackNode *ptr) {
+                return ptr ? ptr->summary : Monoid::identity();
+            }
+
+            //summary of the keys in [lo, hi]: the two boundary paths below the highest node
+            //inside the interval pick up whole subtrees
+            summary_type aggregate(const Key &lo, const Key &hi) const {
+                RedBlackNode *top = head;
+                while (top) {
+                    if (cmp(top->record.first, lo)) top = top->rch;
+                    else if (cmp(hi, top->record.first)) top = top->lch;
+                    else break;
+                }
+                if (!top) return Monoid::identity();
+                summary_type left = Monoid::identity(), right = Monoid::identity();
+                for (RedBlackNode *ptr = top->lch; ptr;) {
+                    if (cmp(ptr->record.first, lo)) ptr = ptr->rch;
+                    else {
+                        left = Monoid::combine(Monoid::combine(Monoid::lift(ptr->record.first, ptr->record.second),
+                                                               summaryOf(ptr->rch)), left);
+                        ptr = ptr->lch;
+                    }
+                }
+                for (RedBlackNode *ptr = top->rch; ptr;) {
+                    if (cmp(hi, ptr->record.first)) ptr = ptr->lch;
+                    else {
+                        right = Monoid::combine(right, Monoid::combine(summaryOf(ptr->lch),
+                                                                       Monoid::lift(ptr->record.first, ptr->record.second)));
+                        ptr = ptr->rch;
+                    }
+                }
+                return Monoid::combine(Monoid::combine(left, Monoid::lift(top->record.first, top->record.second)), right);
+            }
+
+            //the k-th smallest node counting from 0, nullptr for none
+            RedBlackNode *select(size_t k) const {
+                RedBlackNode *ptr = head;
+                while (ptr) {
+                    size_t lsize = sizeOf(ptr->lch);
+                    if (k == lsize) return ptr;
+                    if (k < lsize) ptr = ptr->lch;
+                    else k -= lsize + 1, ptr = ptr->rch;
+                }
+                return nullptr;
+            }
+
+            //number of keys less than key
+            size_t rank(const Key &key) const {
+                RedBlackNode *ptr = head;
+                size_t res = 0;
+                while (ptr) {
+                    if (cmp(ptr->record.first, key)) res += sizeOf(ptr->lch) + 1, ptr = ptr->rch;
+                    else ptr = ptr->lch;
+                }
+                return res;
+            }
+
+            //position of ptr in order, count for nullptr
+            size_t position(const RedBlackNode *ptr) const {
+                if (!ptr) return count;
+                size_t res = sizeOf(ptr->lch);
+                for (; ptr->getParent(); ptr = ptr->getParent())
+                    if (ptr->getParent()->rch == ptr) res += sizeOf(ptr->getParent()->lch) + 1;
+                return res;
+            }
+
+            //the node n steps after ptr (before it for negative n), nullptr stands for end
+            template<class NodePtr>
+            NodePtr advance(NodePtr ptr, int n) const {
+                if (OrderStatistic) {
+                    long long pos = (long long) position(ptr) + n;
+                    if (pos < 0 || pos > (long long) count) throw invalid_iterator();
+                    return select(pos);
+                }
+                for (; n > 0; --n) {
+                    if (ptr == nullptr) throw invalid_iterator();
+                    ptr = ptr->getNext();
+                }
+                for (; n < 0; ++n) {
+                    if (ptr == nullptr) ptr = End;
+                    else ptr = ptr->getPre();
+                    if (ptr == nullptr) throw invalid_iterator();
+                }
+                return ptr;
+            }
+
+            //black height of the subtree of ptr, -1 if a rule is broken in it. n counts its nodes
+            int validate(const RedBlackNode *ptr, const RedBlackNode *parent, size_t &n) const {
+                if (!ptr) return 0;
+                ++n;
+                if (ptr->getParent() != parent) return -1;
+                if (ptr->getColor() == red && (!isBlack(ptr->lch) || !isBlack(ptr->rch))) return -1;
+                if (ptr->lch && !cmp(ptr->lch->record.first, ptr->record.first)) return -1;
+                if (ptr->rch && !cmp(ptr->record.first, ptr->rch->record.first)) return -1;
+                if (OrderStatistic && ptr->getSize() != sizeOf(ptr->lch) + sizeOf(ptr->rch) + 1) return -1;
+                if (!ptr->summarized(ptr->record.first, ptr->record.second, ptr->lch, ptr->rch)) return -1;
+                int l = validate(ptr->lch, ptr, n), r = validate(ptr->rch, ptr, n);
+                if (l < 0 || l != r) return -1;
+                return l + (ptr->getColor() == black);
+            }
+
+            bool valid() const {
+                if (!head) return !Beg && !End && count == 0;
+                if (head->getColor() != black) return false;
+                size_t n = 0;
+                if (validate(head, nullptr, n) < 0 || n != count) return false;
+                if (Beg != leftmost(head) || End != rightmost(head) || Beg->getPre() || End->getNext()) return false;
+                //the threads, or the walk through the tree, visit every node in ascending order
+                n = 1;
+                for (const RedBlackNode *ptr = Beg; ptr != End; ptr = ptr->getNext(), ++n) {
+                    const RedBlackNode *next = ptr->getNext();
+                    if (!next || next->getPre() != ptr || !cmp(ptr->record.first, next->record.first)) return false;
+                }
+                return n == count;
+            }
+
+            //the first node whose key is not less than key, nullptr for none
+            RedBlackNode *lowerBound(const Key &key) const {
+                RedBlackNode *ptr = head, *res = nullptr;
+                while (ptr) {
+                    if (cmp(ptr->record.first, key)) ptr = ptr->rch;
+                    else res = ptr, ptr = ptr->lch;
+                }
+                return res;
+            }
+
+            //the first node whose key is greater than key, nullptr for none
+            RedBlackNode *upperBound(const Key &key) const {
+                RedBlackNode *ptr = head, *res = nullptr;
+                while (ptr) {
+                    if (cmp(key, ptr->record.first)) res = ptr, ptr = ptr->lch;
+                    else ptr = ptr->rch;
+                }
+                return res;
+            }
         } Nebula;
 
+        //an input iterator over the records of a stream for appendSorted,
+        //it stops early when the stream fails
+        template<class IStream>
+        class record_reader {
+        private:
+            IStream *is;
+            unsigned long long remaining;
+            Key key;
+            T value;
+
+            void fetch() {
+                map_serializer<Key>::read(*is, key);
+                map_serializer<T>::read(*is, value);
+                if (!*is) remaining = 0;
+            }
+
+        public:
+            record_reader(IStream *is, unsigned long long n) : is(is), remaining(n), key(), value() {
+                if (remaining) fetch();
+            }
+
+            pair<const Key &, const T &> operator*() const {
+                return pair<const Key &, const T &>(key, value);
+            }
+
+            record_reader &operator++() {
+                if (--remaining) fetch();
+                return *this;
+            }
+
+            bool operator!=(const record_reader &rhs) const {
+                return remaining != rhs.remaining;
+            }
+        };
+
     public:
         typedef pair<const Key, T> value_type;
 
         class const_iterator;
 
         class iterator {
-            friend map<Key, T, Compare>;
+            friend map;
         private:
             RedBlackNode *ptr;
             const RBT *source;
@@ -456,16 +1542,41 @@ namespace sjtu {
 
             iterator(const iterator &other) : ptr(other.ptr), source(other.source) {}
 
+            iterator &operator=(const iterator &other) = default;
+
+            /**
+             * return a new iterator which points n-next elements, as well as operator-.
+             * O(log n) with OrderStatistic and O(n) otherwise.
+             * throw invalid_iterator if the result is out of [begin(), end()]
+             */
+            iterator operator+(const int &n) const {
+                return iterator(source->advance(ptr, n), source);
+            }
+
+            iterator operator-(const int &n) const {
+                return iterator(source->advance(ptr, -n), source);
+            }
+
+            iterator &operator+=(const int &n) {
+                ptr = source->advance(ptr, n);
+                return *this;
+            }
+
+            iterator &operator-=(const int &n) {
+                ptr = source->advance(ptr, -n);
+                return *this;
+            }
+
             iterator operator++(int) {
                 if (ptr == nullptr) throw invalid_iterator();
                 iterator tmp(*this);
-                ptr = ptr->next;
+                ptr = ptr->getNext();
                 return tmp;
             }
 
             iterator &operator++() {
                 if (ptr == nullptr) throw invalid_iterator();
-                ptr = ptr->next;
+                ptr = ptr->getNext();
                 return *this;
             }
 
@@ -475,9 +1586,9 @@ namespace sjtu {
                     ptr = source->End;
                     return iterator(nullptr, source);
                 }
-                if (ptr->pre == nullptr) throw invalid_iterator();
+                if (ptr->getPre() == nullptr) throw invalid_iterator();
                 iterator tmp(*this);
-                ptr = ptr->pre;
+                ptr = ptr->getPre();
                 return tmp;
             }
 
@@ -487,8 +1598,8 @@ namespace sjtu {
                     ptr = source->End;
                     return *this;
                 }
-                if (ptr->pre == nullptr) throw invalid_iterator();
-                ptr = ptr->pre;
+                if (ptr->getPre() == nullptr) throw invalid_iterator();
+                ptr = ptr->getPre();
                 return *this;
             }
 
@@ -519,7 +1630,7 @@ namespace sjtu {
         };
 
         class const_iterator {
-            friend map<Key, T, Compare>;
+            friend map;
         private:
             const RedBlackNode *ptr;
             const RBT *source;
@@ -533,16 +1644,40 @@ namespace sjtu {
 
             const_iterator(const iterator &other) : ptr(other.ptr), source(other.source) {}
 
+            const_iterator &operator=(const const_iterator &other) = default;
+
+            const_iterator operator+(const int &n) const {
+                const_iterator tmp(*this);
+                tmp.ptr = source->advance(ptr, n);
+                return tmp;
+            }
+
+            const_iterator operator-(const int &n) const {
+                const_iterator tmp(*this);
+                tmp.ptr = source->advance(ptr, -n);
+                return tmp;
+            }
+
+            const_iterator &operator+=(const int &n) {
+                ptr = source->advance(ptr, n);
+                return *this;
+            }
+
+            const_iterator &operator-=(const int &n) {
+                ptr = source->advance(ptr, -n);
+                return *this;
+            }
+
             const_iterator operator++(int) {
                 if (ptr == nullptr) throw invalid_iterator();
                 const_iterator tmp(*this);
-                ptr = ptr->next;
+                ptr = ptr->getNext();
                 return tmp;
             }
 
             const_iterator &operator++() {
                 if (ptr == nullptr) throw invalid_iterator();
-                ptr = ptr->next;
+                ptr = ptr->getNext();
                 return *this;
             }
 
@@ -552,9 +1687,9 @@ namespace sjtu {
                     ptr = source->End;
                     return iterator(nullptr, source);
                 }
-                if (ptr->pre == nullptr) throw invalid_iterator();
+                if (ptr->getPre() == nullptr) throw invalid_iterator();
                 const_iterator tmp(*this);
-                ptr = ptr->pre;
+                ptr = ptr->getPre();
                 return tmp;
             }
 
@@ -564,8 +1699,8 @@ namespace sjtu {
                     ptr = source->End;
                     return *this;
                 }
-                if (ptr->pre == nullptr) throw invalid_iterator();
-                ptr = ptr->pre;
+                if (ptr->getPre() == nullptr) throw invalid_iterator();
+                ptr = ptr->getPre();
                 return *this;
             }
 
@@ -597,13 +1732,33 @@ namespace sjtu {
 
         map() {}
 
+        explicit map(const Compare &comp) : Nebula(comp) {}
+
         map(const map &other) : Nebula(other.Nebula) {}
 
+        map(map &&other) : Nebula(std::move(other.Nebula)) {}
+
         map &operator=(const map &other) {
             Nebula = other.Nebula;
             return *this;
         }
 
+        map &operator=(map &&other) {
+            Nebula = std::move(other.Nebula);
+            return *this;
+        }
+
+        /**
+         * build a map from a range sorted by key in O(n).
+         * equal keys keep the first one, an unsorted tail falls back to insert.
+         */
+        template<class InputIterator>
+        static map from_sorted(InputIterator first, InputIterator last, const Compare &comp = Compare()) {
+            map res(comp);
+            res.Nebula.appendSorted(first, last);
+            return res;
+        }
+
         ~map() {}
 
         T &at(const Key &key) {
@@ -621,13 +1776,7 @@ namespace sjtu {
         }
 
         T &operator[](const Key &key) {
-            pointer ptr = Nebula.get(key);
-            if (ptr.second)
-                return ptr.first->record.second;
-            else {
-                pointer ptrr = Nebula.insert(key);
-                return ptrr.first->record.second;
-            }
+            return Nebula.insert(key).first->record.second;
         }
 
         const T &operator[](const Key &key) const {
@@ -669,6 +1818,10 @@ namespace sjtu {
             return (Nebula.head == nullptr);
         }
 
+        Compare key_comp() const {
+            return Nebula.cmp;
+        }
+
         size_t size() const {
             return Nebula.count;
         }
@@ -682,9 +1835,164 @@ namespace sjtu {
             return pair<iterator, bool>(iterator(tmp.first, &Nebula), tmp.second);
         }
 
+        /**
+         * insert value right before hint if it belongs there, which takes two comparisons and
+         * amortized O(1) rotations, and as insert(value) otherwise.
+         * return the element of the key, either inserted or existing.
+         * throw invalid_iterator if hint is of another map
+         */
+        iterator insert(const_iterator hint, const value_type &value) {
+            return emplace_hint(hint, value.first, value.second);
+        }
+
+        /**
+         * try_emplace with a hint like insert(hint, value)
+         */
+        template<class... Args>
+        iterator emplace_hint(const_iterator hint, const Key &key, Args &&... args) {
+            if (&Nebula != hint.source) throw invalid_iterator();
+            pointer tmp = Nebula.insertHint(const_cast<RedBlackNode *>(hint.ptr), key, std::forward<Args>(args)...);
+            return iterator(tmp.first, &Nebula);
+        }
+
+        /**
+         * append a sorted range whose keys are greater than every key in the map.
+         * the range is built into a tree and joined to the map in O(n + log size()).
+         */
+        template<class InputIterator>
+        void merge_sorted(InputIterator first, InputIterator last) {
+            Nebula.appendSorted(first, last);
+        }
+
+        /**
+         * move the elements of other whose keys are not in this map into it, other becomes empty.
+         * elements of this map win on equal keys. both maps are expected to share one ordering.
+         * it costs O(m log(n / m + 1)) for sizes m <= n by splitting the larger tree with the
+         * keys of the smaller one. fork(f, g) runs the independent halves f() and g(),
+         * perhaps on two threads, see map_thread_fork in concurrent_map.hpp.
+         */
+        template<class Fork = map_sequential_fork>
+        void set_union(map &other, const Fork &fork = Fork()) {
+            if (this != &other) Nebula.setOperation(other.Nebula, 0, fork);
+        }
+
+        void merge(map &other) {
+            set_union(other);
+        }
+
+        /**
+         * keep the elements whose keys are in other, other becomes empty
+         */
+        template<class Fork = map_sequential_fork>
+        void set_intersection(map &other, const Fork &fork = Fork()) {
+            if (this != &other) Nebula.setOperation(other.Nebula, 1, fork);
+        }
+
+        /**
+         * erase the elements whose keys are in other, other becomes empty
+         */
+        template<class Fork = map_sequential_fork>
+        void set_difference(map &other, const Fork &fork = Fork()) {
+            if (this != &other) Nebula.setOperation(other.Nebula, 2, fork);
+            else clear();
+        }
+
+        /**
+         * move the elements whose keys are not less than key into right and drop its old ones.
+         * the trees are split in O(log n), counting the sizes walks the smaller part.
+         */
+        void split(const Key &key, map &right) {
+            if (this == &right) return;
+            right.Nebula.Clear();
+            right.Nebula.cmp = Nebula.cmp;
+            Nebula.splitOff(key, right.Nebula);
+        }
+
+        /**
+         * write the elements to os in the binary format of map_header, os provides
+         * write(const char *, size_t) and converts to false on failure like std::ostream.
+         * throw runtime_error if os fails
+         */
+        template<class OStream>
+        void save(OStream &os) const {
+            map_header header;
+            memcpy(header.magic, map_header::expectedMagic(), sizeof(header.magic));
+            header.version = map_header::currentVersion, header.flags = 0;
+            header.keySize = map_serializer<Key>::fixedSize, header.valueSize = map_serializer<T>::fixedSize;
+            header.count = Nebula.count;
+            os.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            for (const RedBlackNode *ptr = Nebula.Beg; ptr; ptr = ptr->getNext()) {
+                map_serializer<Key>::write(os, ptr->record.first);
+                map_serializer<T>::write(os, ptr->record.second);
+            }
+            if (!os) throw runtime_error();
+        }
+
+        /**
+         * replace the elements with those written by save(), the sorted records are
+         * built into a tree in linear time.
+         * throw runtime_error if the header does not match Key and T or the data is cut short,
+         * and the map is left empty then
+         */
+        template<class IStream>
+        void load(IStream &is) {
+            clear();
+            map_header header;
+            is.read(reinterpret_cast<char *>(&header), sizeof(header));
+            if (!is || memcmp(header.magic, map_header::expectedMagic(), sizeof(header.magic)) != 0 ||
+                header.version != map_header::currentVersion ||
+                header.keySize != map_serializer<Key>::fixedSize || header.valueSize != map_serializer<T>::fixedSize)
+                throw runtime_error();
+            Nebula.appendSorted(record_reader<IStream>(&is, header.count), record_reader<IStream>(&is, 0));
+            if (!is) {
+                clear();
+                throw runtime_error();
+            }
+        }
+
+        /**
+         * insert a value constructed from args if key does not exist,
+         * args are left untouched otherwise
+         */
+        template<class... Args>
+        pair<iterator, bool> try_emplace(const Key &key, Args &&... args) {
+            pointer tmp = Nebula.insert(key, std::forward<Args>(args)...);
+            return pair<iterator, bool>(iterator(tmp.first, &Nebula), tmp.second);
+        }
+
+        /**
+         * insert value or assign it to the existing element, the bool is true for insertion
+         */
+        pair<iterator, bool> insert_or_assign(const Key &key, const T &value) {
+            pointer tmp = Nebula.insert(key, value);
+            if (!tmp.second) tmp.first->record.second = value, Nebula.pullPath(tmp.first);
+            return pair<iterator, bool>(iterator(tmp.first, &Nebula), tmp.second);
+        }
+
         void erase(iterator pos) {
             if (&Nebula != pos.source || pos == end()) throw invalid_iterator();
-            Nebula.Delete(pos.ptr->record.first);
+            Nebula.Erase(pos.ptr);
+        }
+
+        /**
+         * erase [first, last) and return last
+         */
+        iterator erase(iterator first, iterator last) {
+            if (&Nebula != first.source || &Nebula != last.source) throw invalid_iterator();
+            while (first != last) {
+                if (first.ptr == nullptr) throw invalid_iterator();
+                RedBlackNode *ptr = first.ptr;
+                first.ptr = ptr->getNext();
+                Nebula.Erase(ptr);
+            }
+            return last;
+        }
+
+        /**
+         * return the number of erased elements (0 or 1)
+         */
+        size_t erase(const Key &key) {
+            return Nebula.Delete(key);
         }
 
         size_t count(const Key &key) const {
@@ -702,8 +2010,134 @@ namespace sjtu {
             if (!tmp.second) return cend();
             return iterator(tmp.first, &Nebula);
         }
+
+        /**
+         * out[i] = find(keys[i]) for i in [0, n).
+         * the lookups go down the tree side by side and prefetch their next nodes,
+         * which hides much of the memory latency on large maps.
+         */
+        void find_batch(const Key *keys, size_t n, iterator *out) {
+            RedBlackNode *nodes[RBT::batchWidth];
+            for (size_t base = 0; base < n; base += RBT::batchWidth) {
+                size_t width = (n - base < RBT::batchWidth) ? n - base : RBT::batchWidth;
+                Nebula.getBatch(keys + base, width, nodes);
+                for (size_t i = 0; i < width; ++i) out[base + i] = iterator(nodes[i], &Nebula);
+            }
+        }
+
+        void find_batch(const Key *keys, size_t n, const_iterator *out) const {
+            RedBlackNode *nodes[RBT::batchWidth];
+            for (size_t base = 0; base < n; base += RBT::batchWidth) {
+                size_t width = (n - base < RBT::batchWidth) ? n - base : RBT::batchWidth;
+                Nebula.getBatch(keys + base, width, nodes);
+                for (size_t i = 0; i < width; ++i) out[base + i] = iterator(nodes[i], &Nebula);
+            }
+        }
+
+        /**
+         * check the red-black rules, the links, the order of the keys and the data kept on
+         * every node in O(n), for tests. with a Monoid its summary_type needs ==
+         */
+        bool valid() const {
+            return Nebula.valid();
+        }
+
+        /**
+         * the k-th smallest element counting from 0, only with OrderStatistic.
+         * throw index_out_of_bound if k >= size()
+         */
+        iterator select(size_t k) {
+            static_assert(OrderStatistic, "select() needs OrderStatistic");
+            if (k >= Nebula.count) throw index_out_of_bound();
+            return iterator(Nebula.select(k), &Nebula);
+        }
+
+        const_iterator select(size_t k) const {
+            static_assert(OrderStatistic, "select() needs OrderStatistic");
+            if (k >= Nebula.count) throw index_out_of_bound();
+            return iterator(Nebula.select(k), &Nebula);
+        }
+
+        typedef typename RBT::summary_type summary_type;
+
+        /**
+         * the summary of the elements whose keys are in [lo, hi] in O(log n), only with a Monoid.
+         * Monoid::identity() for an empty interval
+         */
+        summary_type aggregate(const Key &lo, const Key &hi) const {
+            static_assert(map_subtree_summary<Monoid>::enabled, "aggregate() needs a Monoid");
+            return Nebula.aggregate(lo, hi);
+        }
+
+        /**
+         * recompute the summaries above pos in O(log n) after its value is changed in place,
+         * such as through operator[] or an iterator. insert_or_assign does it by itself.
+         * throw invalid_iterator if pos is end() or of another map
+         */
+        void refresh(iterator pos) {
+            if (&Nebula != pos.source || pos == end()) throw invalid_iterator();
+            Nebula.pullPath(pos.ptr);
+        }
+
+        /**
+         * the number of keys less than key, only with OrderStatistic
+         */
+        size_t rank(const Key &key) const {
+            static_assert(OrderStatistic, "rank() needs OrderStatistic");
+            return Nebula.rank(key);
+        }
+
+        /**
+         * the first element whose key is not less than key, end() for none
+         */
+        iterator lower_bound(const Key &key) {
+            return iterator(Nebula.lowerBound(key), &Nebula);
+        }
+
+        const_iterator lower_bound(const Key &key) const {
+            return iterator(Nebula.lowerBound(key), &Nebula);
+        }
+
+        /**
+         * the first element whose key is greater than key, end() for none
+         */
+        iterator upper_bound(const Key &key) {
+            return iterator(Nebula.upperBound(key), &Nebula);
+        }
+
+        const_iterator upper_bound(const Key &key) const {
+            return iterator(Nebula.upperBound(key), &Nebula);
+        }
+
+        pair<iterator, iterator> equal_range(const Key &key) {
+            return pair<iterator, iterator>(lower_bound(key), upper_bound(key));
+        }
+
+        pair<const_iterator, const_iterator> equal_range(const Key &key) const {
+            return pair<const_iterator, const_iterator>(lower_bound(key), upper_bound(key));
+        }
+
+        /**
+         * call fn on every element whose key is in [lo, hi) in ascending order.
+         * the first one is located in O(log n), the rest are reached by the next thread.
+         */
+        template<class Function>
+        void for_each_in_range(const Key &lo, const Key &hi, Function fn) {
+            for (RedBlackNode *ptr = Nebula.lowerBound(lo); ptr && Nebula.cmp(ptr->record.first, hi); ptr = ptr->getNext())
+                fn(ptr->record);
+        }
+
+        template<class Function>
+        void for_each_in_range(const Key &lo, const Key &hi, Function fn) const {
+            for (const RedBlackNode *ptr = Nebula.lowerBound(lo); ptr && Nebula.cmp(ptr->record.first, hi); ptr = ptr->getNext())
+                fn(static_cast<const value_type &>(ptr->record));
+        }
     };
 
+    //a map answering aggregate() over key intervals, such as with map_sum<T>
+    template<class Key, class T, class Monoid, class Compare = std::less<Key>>
+    using aggregate_map = map<Key, T, Compare, false, false, Monoid>;
+
 }
 
 #endif
@@ -0,0 +1,160 @@
+/**
+ * implement a read-only map over a file written by map::save()
+ */
+#ifndef SJTU_MAP_VIEW_HPP
+#define SJTU_MAP_VIEW_HPP
+
+// only for std::less<T>
+#include <functional>
+#include <cstddef>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "utility.hpp"
+#include "exceptions.hpp"
+#include "map.hpp"
+
+namespace sjtu {
+
+    /**
+     * maps a file saved from a map with trivially copyable Key and T into memory and
+     * searches the records in place by binary search, so opening costs no parsing and
+     * no node is built. pages are read from the file on first touch.
+     * keys and values are returned by copy, since records are not aligned.
+     * the file must not be modified while a view is open.
+     */
+    template<
+            class Key,
+            class T,
+            class Compare = std::less<Key>
+    >
+    class map_view {
+    private:
+        static const size_t stride = sizeof(Key) + sizeof(T);
+
+        const char *base;
+        size_t length, _size;
+        Compare cmp;
+
+        Key keyAt(size_t i) const {
+            Key res;
+            memcpy(&res, base + sizeof(map_header) + i * stride, sizeof(Key));
+            return res;
+        }
+
+        T valueAt(size_t i) const {
+            T res;
+            memcpy(&res, base + sizeof(map_header) + i * stride + sizeof(Key), sizeof(T));
+            return res;
+        }
+
+        //index of the first key not less than key
+        size_t lowerIndex(const Key &key) const {
+            size_t lo = 0, n = _size;
+            while (n) {
+                size_t half = n >> 1;
+                if (cmp(keyAt(lo + half), key)) lo += half + 1, n -= half + 1;
+                else n = half;
+            }
+            return lo;
+        }
+
+        //index of key, _size for not found
+        size_t locate(const Key &key) const {
+            size_t i = lowerIndex(key);
+            return (i < _size && !cmp(key, keyAt(i))) ? i : _size;
+        }
+
+    public:
+        /**
+         * throw runtime_error if the file cannot be mapped or was not saved
+         * from a map of the same Key and T
+         */
+        explicit map_view(const char *path, const Compare &comp = Compare())
+                : base(nullptr), length(0), _size(0), cmp(comp) {
+            static_assert(map_serializer<Key>::fixedSize == sizeof(Key) && map_serializer<T>::fixedSize == sizeof(T),
+                          "map_view needs trivially copyable Key and T");
+            int fd = open(path, O_RDONLY);
+            if (fd < 0) throw runtime_error();
+            struct stat info;
+            if (fstat(fd, &info) != 0 || (size_t) info.st_size < sizeof(map_header)) {
+                close(fd);
+                throw runtime_error();
+            }
+            length = info.st_size;
+            void *addr = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+            close(fd);
+            if (addr == MAP_FAILED) throw runtime_error();
+            base = static_cast<const char *>(addr);
+            map_header header;
+            memcpy(&header, base, sizeof(header));
+            if (memcmp(header.magic, map_header::expectedMagic(), sizeof(header.magic)) != 0 ||
+                header.version != map_header::currentVersion ||
+                header.keySize != sizeof(Key) || header.valueSize != sizeof(T) ||
+                header.count > (length - sizeof(map_header)) / stride) {
+                munmap(const_cast<char *>(base), length);
+                throw runtime_error();
+            }
+            _size = header.count;
+        }
+
+        map_view(const map_view &other) = delete;
+
+        map_view &operator=(const map_view &other) = delete;
+
+        ~map_view() {
+            munmap(const_cast<char *>(base), length);
+        }
+
+        size_t size() const {
+            return _size;
+        }
+
+        bool empty() const {
+            return _size == 0;
+        }
+
+        /**
+         * throw index_out_of_bound if key does not exist
+         */
+        T at(const Key &key) const {
+            size_t i = locate(key);
+            if (i == _size) throw index_out_of_bound();
+            return valueAt(i);
+        }
+
+        /**
+         * copy the value of key into res, false for not found
+         */
+        bool find(const Key &key, T &res) const {
+            size_t i = locate(key);
+            if (i == _size) return false;
+            res = valueAt(i);
+            return true;
+        }
+
+        size_t count(const Key &key) const {
+            return locate(key) != _size;
+        }
+
+        /**
+         * the i-th smallest element counting from 0, throw index_out_of_bound if i >= size()
+         */
+        pair<Key, T> record(size_t i) const {
+            if (i >= _size) throw index_out_of_bound();
+            return pair<Key, T>(keyAt(i), valueAt(i));
+        }
+
+        /**
+         * the number of keys less than key, which is the index of lower_bound
+         */
+        size_t rank(const Key &key) const {
+            return lowerIndex(key);
+        }
+    };
+
+}
+
+#endif
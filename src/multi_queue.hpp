@@ -0,0 +1,195 @@
+/**
+ * implement a relaxed priority queue shared by several threads
+ */
+#ifndef SJTU_MULTI_QUEUE_HPP
+#define SJTU_MULTI_QUEUE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include "exceptions.hpp"
+#include "priority_queue.hpp"
+
+namespace sjtu {
+
+    struct multi_queue_stats {
+        //try_lock calls that found the lane busy
+        size_t lock_failures;
+        //pops whose rank error was measured
+        size_t samples;
+        //lanes whose top was greater than the popped element, over the samples
+        double mean_rank_error;
+        size_t max_rank_error;
+    };
+
+    /**
+     * a MultiQueue: c * p priority_queues, each behind its own lock.
+     * push goes to a random lane, pop compares the tops of two random lanes and takes the greater,
+     * and a busy lane is skipped by try_lock instead of waited for.
+     * pops are relaxed: the element popped is near the top but not always the greatest,
+     * which the rank error statistics describe.
+     */
+    template<typename T, class Compare = std::less<T>, class Heap = dary_heap<4>>
+    class multi_queue {
+    private:
+        //one cache line apart at least, so that neighbouring locks do not share a line
+        class Lane {
+        public:
+            std::mutex lock;
+            priority_queue<T, Compare, Heap> heap;
+            char padding[64];
+
+            Lane() {}
+        };
+
+        typedef std::unique_lock<std::mutex> lane_lock;
+
+        Lane *lanes;
+        size_t count;
+        Compare cmp;
+
+        //every samplePeriod-th pop of a thread is measured, 0 for never
+        std::atomic<size_t> samplePeriod;
+        std::atomic<size_t> failures, samples, rankErrorSum, rankErrorMax;
+
+        static uint64_t &seed() {
+            static std::atomic<uint64_t> threads(0);
+            thread_local uint64_t s = 0x9E3779B97F4A7C15ull * (threads.fetch_add(1) + 1);
+            return s;
+        }
+
+        //xorshift, mapped to [0, count) by a multiply instead of a division
+        size_t pick() const {
+            uint64_t &s = seed();
+            s ^= s << 13;
+            s ^= s >> 7;
+            s ^= s << 17;
+            return (size_t) (((s >> 32) * count) >> 32);
+        }
+
+        //lock every lane in index order and count the tops greater than e
+        void _sample(const T &e) {
+            size_t error = 0;
+            for (size_t i = 0; i < count; ++i) lanes[i].lock.lock();
+            for (size_t i = 0; i < count; ++i)
+                if (!lanes[i].heap.empty() && cmp(e, lanes[i].heap.top())) ++error;
+            for (size_t i = 0; i < count; ++i) lanes[i].lock.unlock();
+            samples.fetch_add(1);
+            rankErrorSum.fetch_add(error);
+            size_t last = rankErrorMax.load();
+            while (last < error && !rankErrorMax.compare_exchange_weak(last, error));
+        }
+
+        bool _take(Lane &lane, T &res) {
+            if (lane.heap.empty()) return false;
+            res = lane.heap.pop_value();
+            return true;
+        }
+
+    public:
+        /**
+         * c lanes for each of the threads, c = 2 is the usual choice
+         */
+        explicit multi_queue(size_t threads = std::thread::hardware_concurrency(), size_t c = 2,
+                             const Compare &comp = Compare())
+                : count((threads ? threads : 1) * (c ? c : 1)), cmp(comp), samplePeriod(0),
+                  failures(0), samples(0), rankErrorSum(0), rankErrorMax(0) {
+            lanes = new Lane[count];
+        }
+
+        multi_queue(const multi_queue &other) = delete;
+
+        multi_queue &operator=(const multi_queue &other) = delete;
+
+        ~multi_queue() {
+            delete[] lanes;
+        }
+
+        void push(const T &e) {
+            while (true) {
+                Lane &lane = lanes[pick()];
+                lane_lock guard(lane.lock, std::try_to_lock);
+                if (guard.owns_lock()) {
+                    lane.heap.push(e);
+                    return;
+                }
+                failures.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        /**
+         * pop an element near the top into res, false if every lane was found empty
+         */
+        bool try_pop(T &res) {
+            bool done = false;
+            for (int attempt = 0; attempt < 4 && !done; ++attempt) {
+                Lane &a = lanes[pick()], &b = lanes[pick()];
+                lane_lock first(a.lock, std::try_to_lock);
+                if (!first.owns_lock()) {
+                    failures.fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+                Lane *best = &a;
+                lane_lock second;
+                if (&b != &a) {
+                    second = lane_lock(b.lock, std::try_to_lock);
+                    if (!second.owns_lock()) failures.fetch_add(1, std::memory_order_relaxed);
+                    else if (!b.heap.empty() && (a.heap.empty() || cmp(a.heap.top(), b.heap.top()))) best = &b;
+                }
+                done = _take(*best, res);
+            }
+            //both samples keep being empty or busy: look at every lane before giving up
+            for (size_t i = 0, start = pick(); i < count && !done; ++i) {
+                Lane &lane = lanes[(start + i) % count];
+                lane_lock guard(lane.lock);
+                done = _take(lane, res);
+            }
+            if (!done) return false;
+            size_t period = samplePeriod.load(std::memory_order_relaxed);
+            if (period) {
+                thread_local size_t pops = 0;
+                if (++pops % period == 0) _sample(res);
+            }
+            return true;
+        }
+
+        /**
+         * measure the rank error of every period-th pop of each thread, 0 to stop.
+         * a measurement locks every lane, so keep the period large outside of tests
+         */
+        void sample_rank_error(size_t period) {
+            samplePeriod = period;
+        }
+
+        multi_queue_stats stats() const {
+            multi_queue_stats res;
+            res.lock_failures = failures.load();
+            res.samples = samples.load();
+            res.mean_rank_error = res.samples ? (double) rankErrorSum.load() / res.samples : 0;
+            res.max_rank_error = rankErrorMax.load();
+            return res;
+        }
+
+        /**
+         * lanes are counted one by one, so the result is exact only without concurrent writers
+         */
+        size_t size() const {
+            size_t res = 0;
+            for (size_t i = 0; i < count; ++i) {
+                lane_lock guard(lanes[i].lock);
+                res += lanes[i].heap.size();
+            }
+            return res;
+        }
+
+        bool empty() const {
+            return size() == 0;
+        }
+    };
+
+}
+
+#endif
@@ -0,0 +1,414 @@
+/**
+ * implement an immutable map sharing nodes between versions
+ */
+#ifndef SJTU_PERSISTENT_MAP_HPP
+#define SJTU_PERSISTENT_MAP_HPP
+
+// only for std::less<T>
+#include <functional>
+#include <cstddef>
+#include "utility.hpp"
+#include "exceptions.hpp"
+#include "map.hpp"
+
+namespace sjtu {
+
+    /**
+     * a red-black tree with path copying: insert() and erase() leave the map untouched and
+     * return a new version, which shares every node off the updated path with the old one.
+     * copying a map is O(1), so it serves as a snapshot.
+     * nodes are reference counted without atomics, so one version must not be used by
+     * several threads while another thread copies or destroys it.
+     */
+    template<
+            class Key,
+            class T,
+            class Compare = std::less<Key>
+    >
+    class persistent_map {
+    public:
+        typedef pair<const Key, T> value_type;
+
+    private:
+
+        enum COLOR {
+            red, black
+        };
+
+        class Node;
+
+        //a counted reference to an immutable node
+        class Ref {
+        public:
+            Node *ptr;
+
+            Ref(Node *ptr = nullptr) : ptr(ptr) {
+                if (ptr) ++ptr->refCount;
+            }
+
+            Ref(const Ref &other) : ptr(other.ptr) {
+                if (ptr) ++ptr->refCount;
+            }
+
+            //other may live in the node released here, so it is counted before
+            Ref &operator=(const Ref &other) {
+                Node *old = ptr;
+                ptr = other.ptr;
+                if (ptr) ++ptr->refCount;
+                drop(old);
+                return *this;
+            }
+
+            ~Ref() {
+                drop(ptr);
+            }
+
+            void release() {
+                Node *old = ptr;
+                ptr = nullptr;
+                drop(old);
+            }
+
+            //nothing is read from node after it is deleted
+            static void drop(Node *node) {
+                if (node && --node->refCount == 0) delete node;
+            }
+
+            Node *operator->() const {
+                return ptr;
+            }
+
+            explicit operator bool() const {
+                return ptr != nullptr;
+            }
+        };
+
+        class Node {
+        public:
+            size_t refCount;
+            COLOR nodeColor;
+            Ref lch, rch;
+            value_type record;
+
+            Node(COLOR col, const Ref &lch, const value_type &record, const Ref &rch) : refCount(0), nodeColor(col),
+                                                                                        lch(lch), rch(rch),
+                                                                                        record(record) {}
+        };
+
+        Ref root;
+        size_t _size;
+        Compare cmp;
+
+        persistent_map(const Ref &root, size_t n, const Compare &comp) : root(root), _size(n), cmp(comp) {}
+
+        int compareKeys(const Key &lhs, const Key &rhs) const {
+            return map_key_compare<Compare, Key>::compare(cmp, lhs, rhs);
+        }
+
+        static bool isRed(const Ref &ptr) {
+            return ptr && ptr->nodeColor == red;
+        }
+
+        //non-empty and black
+        static bool isBlack(const Ref &ptr) {
+            return ptr && ptr->nodeColor == black;
+        }
+
+        static Ref make(COLOR col, const Ref &lch, const value_type &record, const Ref &rch) {
+            return Ref(new Node(col, lch, record, rch));
+        }
+
+        static Ref paint(const Ref &ptr, COLOR col) {
+            if (ptr->nodeColor == col) return ptr;
+            return make(col, ptr->lch, ptr->record, ptr->rch);
+        }
+
+        //rebuild a black node whose subtrees may carry a red-red violation
+        static Ref balance(const Ref &l, const value_type &x, const Ref &r) {
+            if (isRed(l) && isRed(r))
+                return make(red, paint(l, black), x, paint(r, black));
+            if (isRed(l) && isRed(l->lch))
+                return make(red, paint(l->lch, black), l->record, make(black, l->rch, x, r));
+            if (isRed(l) && isRed(l->rch))
+                return make(red, make(black, l->lch, l->record, l->rch->lch), l->rch->record,
+                            make(black, l->rch->rch, x, r));
+            if (isRed(r) && isRed(r->rch))
+                return make(red, make(black, l, x, r->lch), r->record, paint(r->rch, black));
+            if (isRed(r) && isRed(r->lch))
+                return make(red, make(black, l, x, r->lch->lch), r->lch->record,
+                            make(black, r->lch->rch, r->record, r->rch));
+            return make(black, l, x, r);
+        }
+
+        //the left subtree is short of one black node
+        static Ref balanceLeft(const Ref &l, const value_type &x, const Ref &r) {
+            if (isRed(l)) return make(red, paint(l, black), x, r);
+            if (isBlack(r)) return balance(l, x, paint(r, red));
+            return make(red, make(black, l, x, r->lch->lch), r->lch->record,
+                        balance(r->lch->rch, r->record, paint(r->rch, red)));
+        }
+
+        //the right subtree is short of one black node
+        static Ref balanceRight(const Ref &l, const value_type &x, const Ref &r) {
+            if (isRed(r)) return make(red, l, x, paint(r, black));
+            if (isBlack(l)) return balance(paint(l, red), x, r);
+            return make(red, balance(paint(l->lch, red), l->record, l->rch->lch), l->rch->record,
+                        make(black, l->rch->rch, x, r));
+        }
+
+        //concatenate two trees of the same black height, every key in l is less than those in r
+        static Ref append(const Ref &l, const Ref &r) {
+            if (!l) return r;
+            if (!r) return l;
+            if (isRed(l) && isRed(r)) {
+                Ref mid = append(l->rch, r->lch);
+                if (isRed(mid))
+                    return make(red, make(red, l->lch, l->record, mid->lch), mid->record,
+                                make(red, mid->rch, r->record, r->rch));
+                return make(red, l->lch, l->record, make(red, mid, r->record, r->rch));
+            }
+            if (isBlack(l) && isBlack(r)) {
+                Ref mid = append(l->rch, r->lch);
+                if (isRed(mid))
+                    return make(red, make(black, l->lch, l->record, mid->lch), mid->record,
+                                make(black, mid->rch, r->record, r->rch));
+                return balanceLeft(l->lch, l->record, make(black, mid, r->record, r->rch));
+            }
+            if (isRed(r)) return make(red, append(l, r->lch), r->record, r->rch);
+            return make(red, l->lch, l->record, append(l->rch, r));
+        }
+
+        //the same node is returned if nothing changes
+        Ref insertAt(const Ref &ptr, const value_type &value, bool assign) const {
+            if (!ptr) return make(red, Ref(), value, Ref());
+            int res = compareKeys(value.first, ptr->record.first);
+            if (res == 0) {
+                if (!assign) return ptr;
+                return make(ptr->nodeColor, ptr->lch, value, ptr->rch);
+            }
+            if (res < 0) {
+                Ref tmp = insertAt(ptr->lch, value, assign);
+                if (tmp.ptr == ptr->lch.ptr) return ptr;
+                if (ptr->nodeColor == black) return balance(tmp, ptr->record, ptr->rch);
+                return make(red, tmp, ptr->record, ptr->rch);
+            }
+            Ref tmp = insertAt(ptr->rch, value, assign);
+            if (tmp.ptr == ptr->rch.ptr) return ptr;
+            if (ptr->nodeColor == black) return balance(ptr->lch, ptr->record, tmp);
+            return make(red, ptr->lch, ptr->record, tmp);
+        }
+
+        //key must exist in the subtree
+        Ref eraseAt(const Ref &ptr, const Key &key) const {
+            int res = compareKeys(key, ptr->record.first);
+            if (res == 0) return append(ptr->lch, ptr->rch);
+            if (res < 0) {
+                if (isBlack(ptr->lch)) return balanceLeft(eraseAt(ptr->lch, key), ptr->record, ptr->rch);
+                return make(red, eraseAt(ptr->lch, key), ptr->record, ptr->rch);
+            }
+            if (isBlack(ptr->rch)) return balanceRight(ptr->lch, ptr->record, eraseAt(ptr->rch, key));
+            return make(red, ptr->lch, ptr->record, eraseAt(ptr->rch, key));
+        }
+
+        Node *get(const Key &key) const {
+            Node *ptr = root.ptr;
+            while (ptr) {
+                int res = compareKeys(key, ptr->record.first);
+                if (res == 0) return ptr;
+                ptr = (res < 0) ? ptr->lch.ptr : ptr->rch.ptr;
+            }
+            return nullptr;
+        }
+
+    public:
+        /**
+         * iterators walk with the path from the root, as nodes have no parent.
+         * they stay valid as long as some version holding their nodes is alive.
+         */
+        class const_iterator {
+            friend persistent_map;
+        private:
+            //the height of a red-black tree with fewer than 2^48 nodes
+            static const int maxHeight = 96;
+            const Node *path[maxHeight];
+            int depth;
+            const persistent_map *source;
+
+            void pushLeft(const Node *ptr) {
+                for (; ptr; ptr = ptr->lch.ptr) path[depth++] = ptr;
+            }
+
+            void pushRight(const Node *ptr) {
+                for (; ptr; ptr = ptr->rch.ptr) path[depth++] = ptr;
+            }
+
+        public:
+            const_iterator() : depth(0), source(nullptr) {}
+
+            const_iterator(const const_iterator &other) : depth(other.depth), source(other.source) {
+                for (int i = 0; i < depth; ++i) path[i] = other.path[i];
+            }
+
+            const_iterator &operator=(const const_iterator &other) {
+                depth = other.depth, source = other.source;
+                for (int i = 0; i < depth; ++i) path[i] = other.path[i];
+                return *this;
+            }
+
+            const_iterator operator++(int) {
+                const_iterator tmp(*this);
+                ++*this;
+                return tmp;
+            }
+
+            const_iterator &operator++() {
+                if (depth == 0) throw invalid_iterator();
+                const Node *ptr = path[depth - 1];
+                if (ptr->rch) {
+                    pushLeft(ptr->rch.ptr);
+                    return *this;
+                }
+                for (--depth; depth && path[depth - 1]->rch.ptr == ptr; --depth) ptr = path[depth - 1];
+                return *this;
+            }
+
+            const_iterator operator--(int) {
+                const_iterator tmp(*this);
+                --*this;
+                return tmp;
+            }
+
+            const_iterator &operator--() {
+                if (source == nullptr || source->_size == 0) throw invalid_iterator();
+                if (depth == 0) {
+                    pushRight(source->root.ptr);
+                    return *this;
+                }
+                const Node *ptr = path[depth - 1];
+                if (ptr->lch) {
+                    pushRight(ptr->lch.ptr);
+                    return *this;
+                }
+                int tmp = depth;
+                for (--tmp; tmp && path[tmp - 1]->lch.ptr == ptr; --tmp) ptr = path[tmp - 1];
+                if (tmp == 0) throw invalid_iterator();
+                depth = tmp;
+                return *this;
+            }
+
+            const value_type &operator*() const {
+                if (depth == 0) throw invalid_iterator();
+                return path[depth - 1]->record;
+            }
+
+            const value_type *operator->() const noexcept {
+                return &(path[depth - 1]->record);
+            }
+
+            bool operator==(const const_iterator &rhs) const {
+                if (source != rhs.source || depth != rhs.depth) return false;
+                return depth == 0 || path[depth - 1] == rhs.path[depth - 1];
+            }
+
+            bool operator!=(const const_iterator &rhs) const {
+                return !(*this == rhs);
+            }
+        };
+
+        typedef const_iterator iterator;
+
+        persistent_map() : _size(0) {}
+
+        explicit persistent_map(const Compare &comp) : _size(0), cmp(comp) {}
+
+        persistent_map(const persistent_map &other) = default;
+
+        persistent_map &operator=(const persistent_map &other) = default;
+
+        ~persistent_map() {}
+
+        size_t size() const {
+            return _size;
+        }
+
+        bool empty() const {
+            return _size == 0;
+        }
+
+        /**
+         * throw index_out_of_bound if key does not exist
+         */
+        const T &at(const Key &key) const {
+            Node *ptr = get(key);
+            if (!ptr) throw index_out_of_bound();
+            return ptr->record.second;
+        }
+
+        size_t count(const Key &key) const {
+            return get(key) != nullptr;
+        }
+
+        /**
+         * a version with value inserted, or this version if the key exists
+         */
+        persistent_map insert(const value_type &value) const {
+            Ref res = insertAt(root, value, false);
+            if (res.ptr == root.ptr) return *this;
+            return persistent_map(paint(res, black), _size + 1, cmp);
+        }
+
+        /**
+         * a version where key maps to value
+         */
+        persistent_map insert_or_assign(const Key &key, const T &value) const {
+            bool found = get(key) != nullptr;
+            Ref res = insertAt(root, value_type(key, value), true);
+            return persistent_map(paint(res, black), _size + !found, cmp);
+        }
+
+        /**
+         * a version without key, or this version if it does not exist
+         */
+        persistent_map erase(const Key &key) const {
+            if (!get(key)) return *this;
+            Ref res = eraseAt(root, key);
+            return persistent_map(res ? paint(res, black) : res, _size - 1, cmp);
+        }
+
+        const_iterator find(const Key &key) const {
+            const_iterator res;
+            res.source = this;
+            for (const Node *ptr = root.ptr; ptr;) {
+                res.path[res.depth++] = ptr;
+                int tmp = compareKeys(key, ptr->record.first);
+                if (tmp == 0) return res;
+                ptr = (tmp < 0) ? ptr->lch.ptr : ptr->rch.ptr;
+            }
+            return cend();
+        }
+
+        const_iterator cbegin() const {
+            const_iterator res;
+            res.source = this;
+            res.pushLeft(root.ptr);
+            return res;
+        }
+
+        const_iterator cend() const {
+            const_iterator res;
+            res.source = this;
+            return res;
+        }
+
+        const_iterator begin() const {
+            return cbegin();
+        }
+
+        const_iterator end() const {
+            return cend();
+        }
+    };
+
+}
+
+#endif
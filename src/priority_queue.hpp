@@ -3,15 +3,37 @@
 
 #include <cstddef>
 #include <functional>
+#include <new>
+#include <utility>
 #include "exceptions.hpp"
 
 namespace sjtu {
 
+    //heap implementations of priority_queue
+
+    //linked binomial trees: O(log n) push, pop and merge
+    class binomial_heap {};
+
+    //one contiguous D-ary heap: no allocation per element and fewer cache misses,
+    //but merge costs O(n)
+    template<size_t D = 4>
+    class dary_heap {};
+
+    //a pairing heap with handles for decrease_key and erase, O(1) push and merge
+    class pairing_heap {};
+
+    //binomial trees linked only in pop: O(1) push and merge, lighter nodes than pairing_heap
+    class lazy_binomial_heap {};
+
 /**
  * a container like std::priority_queue which is a heap internal.
+ * Heap chooses the implementation, binomial_heap if merge has to be fast.
  */
-    template<typename T, class Compare = std::less<T>>
-    class priority_queue {
+    template<typename T, class Compare = std::less<T>, class Heap = binomial_heap>
+    class priority_queue;
+
+    template<typename T, class Compare>
+    class priority_queue<T, Compare, binomial_heap> {
     private:
 
         Compare cmp;
@@ -22,11 +44,16 @@ namespace sjtu {
             T value;
             Node *child, *tail, *next;
 
-            explicit Node(T e = T(), size_t n = 1) : value(e), next(nullptr), num(n), child(nullptr), tail(nullptr) {}
+            template<class... Args>
+            explicit Node(size_t n, Args &&... args)
+                    : num(n), value(std::forward<Args>(args)...), child(nullptr), tail(nullptr), next(nullptr) {}
         };
 
         Node *root;
 
+        //the root holding the top value, nullptr iff the queue is empty
+        Node *best;
+
         size_t _size;
 
         Node *_copy(Node *&ptr, Node *another) {
@@ -34,7 +61,7 @@ namespace sjtu {
                 ptr = nullptr;
                 return nullptr;
             }
-            ptr = new Node(another->value, another->num);
+            ptr = new Node(another->num, another->value);
             Node *tmp = _copy(ptr->next, another->next);
             ptr->tail = _copy(ptr->child, another->child);
             return ((!tmp) ? ptr : tmp);
@@ -70,12 +97,22 @@ namespace sjtu {
             }
         }
 
+        //scan the roots for the top one, there are O(log n) of them
+        void _update_best() {
+            best = root;
+            if (!root) return;
+            for (Node *i = root->next; i; i = i->next) {
+                if (cmp(best->value, i->value))
+                    best = i;
+            }
+        }
+
         void clear() {
             for (Node *i = root, *j; i; i = j) {
                 j = i->next;
                 Node_Free(i);
             }
-            root = nullptr;
+            root = best = nullptr;
         }
 
         void Node_Free(Node *ptr) {
@@ -94,9 +131,11 @@ namespace sjtu {
             for (Node *i = ptr, *j; i; i = j) {
                 Node *cur;
                 j = i->next;
-                if (root->num > i->num) {
+                //an equal root has to be linked as well, or the root list keeps two trees of one size
+                if (root->num >= i->num) {
                     i->next = root;
                     root = i;
+                    _merge(root);
                     continue;
                 }
 
@@ -109,11 +148,70 @@ namespace sjtu {
             }
         }
 
+        //a and b have the same size, the child list stays ordered by size
+        Node *_link(Node *a, Node *b) {
+            if (cmp(a->value, b->value)) {
+                Node *tmp = a;
+                a = b;
+                b = tmp;
+            }
+            if (!a->child) a->child = a->tail = b;
+            else {
+                a->tail->next = b;
+                a->tail = b;
+            }
+            b->next = nullptr;
+            a->num <<= 1;
+            return a;
+        }
+
+        //counting in binary with one tree for each bit, O(n) links in all
+        template<class InputIterator>
+        void _build(InputIterator first, InputIterator last) {
+            Node *slot[sizeof(size_t) * 8] = {};
+            size_t used = 0;
+            for (; first != last; ++first, ++_size) {
+                Node *ptr = new Node(1, *first);
+                size_t r = 0;
+                for (; slot[r]; ++r) {
+                    ptr = _link(ptr, slot[r]);
+                    slot[r] = nullptr;
+                }
+                slot[r] = ptr;
+                if (r >= used) used = r + 1;
+            }
+            Node **tail = &root;
+            for (size_t r = 0; r < used; ++r)
+                if (slot[r]) {
+                    *tail = slot[r];
+                    tail = &slot[r]->next;
+                }
+            *tail = nullptr;
+            _update_best();
+        }
+
     public:
-        priority_queue() : root(nullptr), _size(0) {}
+        priority_queue() : root(nullptr), best(nullptr), _size(0) {}
+
+        /**
+         * O(n) and cheaper than n pushes
+         */
+        template<class InputIterator>
+        priority_queue(InputIterator first, InputIterator last) : root(nullptr), best(nullptr), _size(0) {
+            _build(first, last);
+        }
 
         priority_queue(const priority_queue &other) : _size(other._size) {
             _copy(root, other.root);
+            _update_best();
+        }
+
+        /**
+         * O(1), other is empty afterwards
+         */
+        priority_queue(priority_queue &&other) : cmp(std::move(other.cmp)), root(other.root), best(other.best), _size(other._size) {
+            other.root = other.best = nullptr;
+            other._size = 0;
         }
 
         ~priority_queue() {
@@ -127,32 +225,65 @@ namespace sjtu {
             if (this == &other) return *this;
             clear();
             _copy(root, other.root);
+            _update_best();
             _size=other._size;
             return *this;
         }
 
+        priority_queue &operator=(priority_queue &&other) {
+            if (this == &other) return *this;
+            clear();
+            cmp = std::move(other.cmp);
+            root = other.root;
+            best = other.best;
+            _size = other._size;
+            other.root = other.best = nullptr;
+            other._size = 0;
+            return *this;
+        }
+
+        /**
+         * replace the elements with [first, last) in O(n)
+         */
+        template<class InputIterator>
+        void assign(InputIterator first, InputIterator last) {
+            clear();
+            _size = 0;
+            _build(first, last);
+        }
+
         const T &top() const {
             if (!root) {
                 throw container_is_empty();
             }
-            Node *res = root;
-            for (Node *i = root->next; i; i = i->next) {
-                if (cmp(res->value, i->value))
-                    res = i;
-            }
-            return res->value;
+            return best->value;
         }
 
         void push(const T &e) {
+            emplace(e);
+        }
+
+        void push(T &&e) {
+            emplace(std::move(e));
+        }
+
+        /**
+         * construct the element in its node from args
+         */
+        template<class... Args>
+        void emplace(Args &&... args) {
+            Node *tmp = new Node(1, std::forward<Args>(args)...);
             ++_size;
             if (!root) {
-                root = new Node(e, 1);
+                root = best = tmp;
             }
             else {
-                Node *tmp = new Node(e);
                 tmp->next = root;
                 root = tmp;
                 _merge(root);
+                //if best has been linked under root by the carries, root is not less than it
+                if (!cmp(root->value, best->value))
+                    best = root;
             }
         }
 
@@ -162,14 +293,9 @@ namespace sjtu {
             }
             --_size;
             Node *pre_t = nullptr;
-            Node *now_t = root;
-            T res = root->value;
-            for (Node *now = root->next, *pre = root; now; pre = now, now = now->next) {
-                if (cmp(res, now->value)) {
-                    res = now->value;
-                    pre_t = pre;
-                    now_t = now;
-                }
+            Node *now_t = best;
+            if (best != root) {
+                for (pre_t = root; pre_t->next != best; pre_t = pre_t->next);
             }
             if (!pre_t) {
                 root = root->next;
@@ -179,6 +305,19 @@ namespace sjtu {
             }
             _insert(now_t->child);
             delete now_t;
+            _update_best();
+        }
+
+        /**
+         * pop and return the top element, which is moved out instead of copied
+         */
+        T pop_value() {
+            if (!root) {
+                throw container_is_empty();
+            }
+            T res(std::move(best->value));
+            pop();
+            return res;
         }
 
         size_t size() const {
@@ -190,12 +329,822 @@ namespace sjtu {
         }
 
         void merge(priority_queue &other) {
+            if (this == &other) return;
             _insert(other.root);
-            other.root = nullptr;
+            _update_best();
+            _size += other._size;
+            other.root = other.best = nullptr;
             other._size=0;
         }
     };
 
+    /**
+     * the heap is laid out from slot D - 1 of a buffer aligned to a cache line,
+     * so the D children of a node start at a multiple of D and share as few lines as possible.
+     * push and pop move elements along one path instead of allocating nodes.
+     */
+    template<typename T, class Compare, size_t D>
+    class priority_queue<T, Compare, dary_heap<D>> {
+    private:
+        static_assert(D >= 2, "dary_heap needs D >= 2");
+        static const size_t cacheLine = 64;
+
+        Compare cmp;
+
+        //raw is what operator new returned, heap[0] is the top
+        char *raw;
+        T *heap;
+        size_t _size, capacity;
+
+        void _allocate(size_t cap) {
+            raw = static_cast<char *>(::operator new((cap + D - 1) * sizeof(T) + cacheLine));
+            size_t offset = (cacheLine - reinterpret_cast<size_t>(raw) % cacheLine) % cacheLine;
+            heap = reinterpret_cast<T *>(raw + offset) + (D - 1);
+            capacity = cap;
+        }
+
+        void _release() {
+            for (size_t i = 0; i < _size; ++i) heap[i].~T();
+            ::operator delete(raw);
+        }
+
+        //a moved-from queue has no buffer
+        void _grow() {
+            _reserve(capacity ? capacity << 1 : cacheLine / sizeof(T) + 1);
+        }
+
+        void _reserve(size_t cap) {
+            char *oldRaw = raw;
+            T *oldHeap = heap;
+            _allocate(cap);
+            for (size_t i = 0; i < _size; ++i) {
+                new(heap + i) T(std::move(oldHeap[i]));
+                oldHeap[i].~T();
+            }
+            ::operator delete(oldRaw);
+        }
+
+        void _copy(const priority_queue &other) {
+            _allocate(other.capacity);
+            try {
+                for (_size = 0; _size < other._size; ++_size) new(heap + _size) T(other.heap[_size]);
+            } catch (...) {
+                _release();
+                throw;
+            }
+        }
+
+        //move value up from the hole
+        void _sift_up(size_t hole, T &value) {
+            while (hole) {
+                size_t parent = (hole - 1) / D;
+                if (!cmp(heap[parent], value)) break;
+                heap[hole] = std::move(heap[parent]);
+                hole = parent;
+            }
+            heap[hole] = std::move(value);
+        }
+
+        //move value down from the hole
+        void _sift_down(size_t hole, T &value) {
+            while (true) {
+                size_t first = hole * D + 1, best = first;
+                if (first >= _size) break;
+                size_t last = (first + D < _size) ? first + D : _size;
+                for (size_t i = first + 1; i < last; ++i)
+                    if (cmp(heap[best], heap[i])) best = i;
+                if (!cmp(value, heap[best])) break;
+                heap[hole] = std::move(heap[best]);
+                hole = best;
+            }
+            heap[hole] = std::move(value);
+        }
+
+        //Floyd's bottom-up construction in O(n)
+        void _heapify() {
+            if (_size < 2) return;
+            for (size_t i = (_size - 2) / D + 1; i-- > 0;) {
+                T value(std::move(heap[i]));
+                _sift_down(i, value);
+            }
+        }
+
+        template<class InputIterator>
+        void _build(InputIterator first, InputIterator last) {
+            for (; first != last; ++first) {
+                if (_size == capacity) _grow();
+                new(heap + _size++) T(*first);
+            }
+            _heapify();
+        }
+
+    public:
+        priority_queue() : raw(nullptr), heap(nullptr), _size(0), capacity(0) {}
+
+        /**
+         * O(n) by Floyd's heapify
+         */
+        template<class InputIterator>
+        priority_queue(InputIterator first, InputIterator last) : raw(nullptr), heap(nullptr), _size(0), capacity(0) {
+            _build(first, last);
+        }
+
+        priority_queue(const priority_queue &other) : cmp(other.cmp) {
+            _copy(other);
+        }
+
+        /**
+         * O(1), the buffer is taken over and other is left without one
+         */
+        priority_queue(priority_queue &&other)
+                : cmp(std::move(other.cmp)), raw(other.raw), heap(other.heap), _size(other._size), capacity(other.capacity) {
+            other.raw = nullptr;
+            other.heap = nullptr;
+            other._size = other.capacity = 0;
+        }
+
+        ~priority_queue() {
+            _release();
+        }
+
+        /**
+         * the copy is made before the old buffer is released, so a throwing copy leaves *this untouched
+         */
+        priority_queue &operator=(const priority_queue &other) {
+            if (this == &other) return *this;
+            priority_queue tmp(other);
+            return *this = std::move(tmp);
+        }
+
+        priority_queue &operator=(priority_queue &&other) {
+            if (this == &other) return *this;
+            _release();
+            cmp = std::move(other.cmp);
+            raw = other.raw;
+            heap = other.heap;
+            _size = other._size;
+            capacity = other.capacity;
+            other.raw = nullptr;
+            other.heap = nullptr;
+            other._size = other.capacity = 0;
+            return *this;
+        }
+
+        /**
+         * replace the elements with [first, last) in O(n), the buffer is kept
+         */
+        template<class InputIterator>
+        void assign(InputIterator first, InputIterator last) {
+            for (size_t i = 0; i < _size; ++i) heap[i].~T();
+            _size = 0;
+            _build(first, last);
+        }
+
+        const T &top() const {
+            if (!_size) {
+                throw container_is_empty();
+            }
+            return heap[0];
+        }
+
+        void push(const T &e) {
+            emplace(e);
+        }
+
+        void push(T &&e) {
+            emplace(std::move(e));
+        }
+
+        /**
+         * construct the element at the end of the buffer from args
+         */
+        template<class... Args>
+        void emplace(Args &&... args) {
+            if (_size == capacity) _grow();
+            new(heap + _size) T(std::forward<Args>(args)...);
+            T value(std::move(heap[_size]));
+            _sift_up(_size++, value);
+        }
+
+        void pop() {
+            if (!_size) {
+                throw container_is_empty();
+            }
+            T value(std::move(heap[--_size]));
+            heap[_size].~T();
+            if (_size) _sift_down(0, value);
+        }
+
+        /**
+         * pop and return the top element, which is moved out instead of copied
+         */
+        T pop_value() {
+            if (!_size) {
+                throw container_is_empty();
+            }
+            T res(std::move(heap[0]));
+            pop();
+            return res;
+        }
+
+        size_t size() const {
+            return _size;
+        }
+
+        bool empty() const {
+            return (_size == 0);
+        }
+
+        /**
+         * O(m log n) for a small other and O(n + m) by heapifying again otherwise
+         */
+        void merge(priority_queue &other) {
+            if (this == &other) return;
+            if (_size + other._size > capacity)
+                _reserve((_size + other._size > capacity << 1) ? _size + other._size : capacity << 1);
+            bool rebuild = other._size * 8 > _size;
+            for (size_t i = 0; i < other._size; ++i) {
+                new(heap + _size) T(std::move(other.heap[i]));
+                other.heap[i].~T();
+                if (rebuild) ++_size;
+                else {
+                    T value(std::move(heap[_size]));
+                    _sift_up(_size++, value);
+                }
+            }
+            other._size = 0;
+            if (rebuild) _heapify();
+        }
+    };
+
+    /**
+     * a pairing heap whose elements stay at their nodes, so push hands out a handle
+     * through which the element can later be modified or erased.
+     * a child points back to its left sibling, or to its parent if it is the first child.
+     */
+    template<typename T, class Compare>
+    class priority_queue<T, Compare, pairing_heap> {
+    private:
+        class Node {
+        public:
+            T value;
+            Node *child, *prev, *next;
+
+            template<class... Args>
+            explicit Node(Args &&... args) : value(std::forward<Args>(args)...), child(nullptr), prev(nullptr), next(nullptr) {}
+        };
+
+        Compare cmp;
+        Node *root;
+        size_t _size;
+
+        //a and b are detached roots, the loser becomes the first child of the winner
+        Node *_link(Node *a, Node *b) {
+            if (!a) return b;
+            if (!b) return a;
+            if (cmp(a->value, b->value)) {
+                Node *tmp = a;
+                a = b;
+                b = tmp;
+            }
+            b->next = a->child;
+            if (a->child) a->child->prev = b;
+            b->prev = a;
+            a->child = b;
+            a->prev = a->next = nullptr;
+            return a;
+        }
+
+        //take a non-root node out of its sibling list together with its subtree
+        void _cut(Node *ptr) {
+            if (ptr->prev->child == ptr) ptr->prev->child = ptr->next;
+            else ptr->prev->next = ptr->next;
+            if (ptr->next) ptr->next->prev = ptr->prev;
+            ptr->prev = ptr->next = nullptr;
+        }
+
+        //two-pass pairing of a sibling list into one tree
+        Node *_combine(Node *first) {
+            Node *paired = nullptr;
+            while (first) {
+                Node *a = first, *b = a->next;
+                first = b ? b->next : nullptr;
+                a->prev = a->next = nullptr;
+                if (b) b->prev = b->next = nullptr;
+                a = _link(a, b);
+                a->next = paired;
+                paired = a;
+            }
+            if (!paired) return nullptr;
+            Node *res = paired;
+            paired = paired->next;
+            res->next = nullptr;
+            while (paired) {
+                Node *tmp = paired->next;
+                paired->next = nullptr;
+                res = _link(res, paired);
+                paired = tmp;
+            }
+            return res;
+        }
+
+        Node *_parent(Node *ptr) const {
+            while (ptr->prev && ptr->prev->child != ptr) ptr = ptr->prev;
+            return ptr->prev;
+        }
+
+        //preorder walk along the links, without recursion or a stack
+        void _copy(const priority_queue &other) {
+            Node *ptr = other.root;
+            while (ptr) {
+                push(ptr->value);
+                if (ptr->child) {
+                    ptr = ptr->child;
+                    continue;
+                }
+                while (ptr && !ptr->next) ptr = _parent(ptr);
+                if (ptr) ptr = ptr->next;
+            }
+        }
+
+        //each link is O(1) already, and the first pop pairs the children in allocation order
+        template<class InputIterator>
+        void _build(InputIterator first, InputIterator last) {
+            for (; first != last; ++first, ++_size) root = _link(root, new Node(*first));
+        }
+
+        //pending nodes are chained through next, children are spliced in front
+        void _clear() {
+            Node *stack = root;
+            while (stack) {
+                Node *ptr = stack;
+                stack = ptr->next;
+                if (ptr->child) {
+                    Node *last = ptr->child;
+                    while (last->next) last = last->next;
+                    last->next = stack;
+                    stack = ptr->child;
+                }
+                delete ptr;
+            }
+            root = nullptr;
+            _size = 0;
+        }
+
+    public:
+        /**
+         * refers to an element from its push until it is popped or erased.
+         * after a merge the handles of the other queue belong to this one.
+         */
+        class handle {
+            friend class priority_queue;
+
+        private:
+            Node *node;
+
+            explicit handle(Node *ptr) : node(ptr) {}
+
+        public:
+            handle() : node(nullptr) {}
+
+            bool operator==(const handle &rhs) const {
+                return node == rhs.node;
+            }
+
+            bool operator!=(const handle &rhs) const {
+                return node != rhs.node;
+            }
+        };
+
+        priority_queue() : root(nullptr), _size(0) {}
+
+        /**
+         * O(n)
+         */
+        template<class InputIterator>
+        priority_queue(InputIterator first, InputIterator last) : root(nullptr), _size(0) {
+            _build(first, last);
+        }
+
+        priority_queue(const priority_queue &other) : cmp(other.cmp), root(nullptr), _size(0) {
+            _copy(other);
+        }
+
+        /**
+         * O(1), handles of other belong to this queue afterwards
+         */
+        priority_queue(priority_queue &&other) : cmp(std::move(other.cmp)), root(other.root), _size(other._size) {
+            other.root = nullptr;
+            other._size = 0;
+        }
+
+        ~priority_queue() {
+            _clear();
+        }
+
+        priority_queue &operator=(const priority_queue &other) {
+            if (this == &other) return *this;
+            _clear();
+            cmp = other.cmp;
+            _copy(other);
+            return *this;
+        }
+
+        priority_queue &operator=(priority_queue &&other) {
+            if (this == &other) return *this;
+            _clear();
+            cmp = std::move(other.cmp);
+            root = other.root;
+            _size = other._size;
+            other.root = nullptr;
+            other._size = 0;
+            return *this;
+        }
+
+        /**
+         * replace the elements with [first, last) in O(n), handles of the old elements are invalid
+         */
+        template<class InputIterator>
+        void assign(InputIterator first, InputIterator last) {
+            _clear();
+            _build(first, last);
+        }
+
+        const T &top() const {
+            if (!root) {
+                throw container_is_empty();
+            }
+            return root->value;
+        }
+
+        handle push(const T &e) {
+            return emplace(e);
+        }
+
+        handle push(T &&e) {
+            return emplace(std::move(e));
+        }
+
+        /**
+         * construct the element in its node from args
+         */
+        template<class... Args>
+        handle emplace(Args &&... args) {
+            Node *ptr = new Node(std::forward<Args>(args)...);
+            root = _link(root, ptr);
+            ++_size;
+            return handle(ptr);
+        }
+
+        void pop() {
+            if (!root) {
+                throw container_is_empty();
+            }
+            Node *tmp = root;
+            root = _combine(root->child);
+            delete tmp;
+            --_size;
+        }
+
+        /**
+         * pop and return the top element, which is moved out instead of copied
+         */
+        T pop_value() {
+            if (!root) {
+                throw container_is_empty();
+            }
+            T res(std::move(root->value));
+            pop();
+            return res;
+        }
+
+        /**
+         * throw invalid_iterator if h is a null handle
+         */
+        const T &value(const handle &h) const {
+            if (!h.node) throw invalid_iterator();
+            return h.node->value;
+        }
+
+        /**
+         * change the element of h to e in either direction.
+         * moving toward the top costs O(1), moving away costs as much as a pop.
+         * throw invalid_iterator if h is a null handle
+         */
+        void modify(const handle &h, const T &e) {
+            Node *ptr = h.node;
+            if (!ptr) throw invalid_iterator();
+            bool raised = !cmp(e, ptr->value);
+            ptr->value = e;
+            if (raised) {
+                if (ptr != root) {
+                    _cut(ptr);
+                    root = _link(root, ptr);
+                }
+                return;
+            }
+            Node *sub = _combine(ptr->child);
+            ptr->child = nullptr;
+            if (ptr == root) root = _link(ptr, sub);
+            else {
+                _cut(ptr);
+                root = _link(root, _link(ptr, sub));
+            }
+        }
+
+        /**
+         * move the element of h toward the top, the name follows the min-heap convention.
+         * throw runtime_error if e ranks below the current element
+         * and invalid_iterator if h is a null handle
+         */
+        void decrease_key(const handle &h, const T &e) {
+            if (!h.node) throw invalid_iterator();
+            if (cmp(e, h.node->value)) throw runtime_error();
+            modify(h, e);
+        }
+
+        /**
+         * remove the element of h, h is invalid afterwards.
+         * throw invalid_iterator if h is a null handle
+         */
+        void erase(const handle &h) {
+            Node *ptr = h.node;
+            if (!ptr) throw invalid_iterator();
+            if (ptr == root) {
+                pop();
+                return;
+            }
+            _cut(ptr);
+            root = _link(root, _combine(ptr->child));
+            delete ptr;
+            --_size;
+        }
+
+        size_t size() const {
+            return _size;
+        }
+
+        bool empty() const {
+            return (_size == 0);
+        }
+
+        /**
+         * O(1), other is empty afterwards
+         */
+        void merge(priority_queue &other) {
+            if (this == &other) return;
+            root = _link(root, other.root);
+            _size += other._size;
+            other.root = nullptr;
+            other._size = 0;
+        }
+    };
+
+    /**
+     * a binomial heap that only links trees in pop.
+     * push appends a root and merge splices two root lists, both in O(1),
+     * pop links the roots and the children of the top into one tree per rank, O(log n) amortized.
+     */
+    template<typename T, class Compare>
+    class priority_queue<T, Compare, lazy_binomial_heap> {
+    private:
+        static const size_t maxRank = sizeof(size_t) * 8;
+
+        class Node {
+        public:
+            size_t rank;
+            T value;
+            Node *child, *next;
+
+            template<class... Args>
+            explicit Node(Args &&... args) : rank(0), value(std::forward<Args>(args)...), child(nullptr), next(nullptr) {}
+        };
+
+        Compare cmp;
+
+        //the root list from root to tail, best holds the top value
+        Node *root, *tail, *best;
+        size_t _size;
+
+        void _append(Node *ptr) {
+            ptr->next = nullptr;
+            if (!root) root = tail = best = ptr;
+            else {
+                tail->next = ptr;
+                tail = ptr;
+                if (cmp(best->value, ptr->value)) best = ptr;
+            }
+        }
+
+        //both trees have the same rank, the loser becomes a child of the winner
+        Node *_link(Node *a, Node *b) {
+            if (cmp(a->value, b->value)) {
+                Node *tmp = a;
+                a = b;
+                b = tmp;
+            }
+            b->next = a->child;
+            a->child = b;
+            ++a->rank;
+            return a;
+        }
+
+        //link ptr with the tree of the same rank until its rank is free
+        void _place(Node **bucket, Node *ptr) {
+            while (bucket[ptr->rank]) {
+                Node *other = bucket[ptr->rank];
+                bucket[ptr->rank] = nullptr;
+                ptr = _link(ptr, other);
+            }
+            bucket[ptr->rank] = ptr;
+        }
+
+        //a throwing copy frees what it has built
+        Node *_copy(const Node *another) {
+            Node *res = nullptr, *last = nullptr;
+            try {
+                for (; another; another = another->next) {
+                    Node *ptr = new Node(another->value);
+                    ptr->rank = another->rank;
+                    if (last) last->next = ptr;
+                    else res = ptr;
+                    last = ptr;
+                    ptr->child = _copy(another->child);
+                }
+            } catch (...) {
+                _free(res);
+                throw;
+            }
+            return res;
+        }
+
+        void _free(Node *ptr) {
+            for (Node *i = ptr, *j; i; i = j) {
+                j = i->next;
+                _free(i->child);
+                delete i;
+            }
+        }
+
+        void _assign(const priority_queue &other) {
+            root = tail = best = nullptr;
+            for (Node *i = _copy(other.root), *j; i; i = j) {
+                j = i->next;
+                _append(i);
+            }
+            _size = other._size;
+        }
+
+        template<class InputIterator>
+        void _build(InputIterator first, InputIterator last) {
+            for (; first != last; ++first, ++_size) _append(new Node(*first));
+        }
+
+    public:
+        priority_queue() : root(nullptr), tail(nullptr), best(nullptr), _size(0) {}
+
+        /**
+         * O(n), the trees are linked by the first pop
+         */
+        template<class InputIterator>
+        priority_queue(InputIterator first, InputIterator last) : root(nullptr), tail(nullptr), best(nullptr), _size(0) {
+            _build(first, last);
+        }
+
+        priority_queue(const priority_queue &other) : cmp(other.cmp) {
+            _assign(other);
+        }
+
+        /**
+         * O(1), other is empty afterwards
+         */
+        priority_queue(priority_queue &&other)
+                : cmp(std::move(other.cmp)), root(other.root), tail(other.tail), best(other.best), _size(other._size) {
+            other.root = other.tail = other.best = nullptr;
+            other._size = 0;
+        }
+
+        ~priority_queue() {
+            _free(root);
+        }
+
+        /**
+         * the copy is made before the old trees are freed, so a throwing copy leaves *this untouched
+         */
+        priority_queue &operator=(const priority_queue &other) {
+            if (this == &other) return *this;
+            priority_queue tmp(other);
+            return *this = std::move(tmp);
+        }
+
+        priority_queue &operator=(priority_queue &&other) {
+            if (this == &other) return *this;
+            _free(root);
+            cmp = std::move(other.cmp);
+            root = other.root;
+            tail = other.tail;
+            best = other.best;
+            _size = other._size;
+            other.root = other.tail = other.best = nullptr;
+            other._size = 0;
+            return *this;
+        }
+
+        /**
+         * replace the elements with [first, last) in O(n)
+         */
+        template<class InputIterator>
+        void assign(InputIterator first, InputIterator last) {
+            _free(root);
+            root = tail = best = nullptr;
+            _size = 0;
+            _build(first, last);
+        }
+
+        const T &top() const {
+            if (!root) {
+                throw container_is_empty();
+            }
+            return best->value;
+        }
+
+        void push(const T &e) {
+            emplace(e);
+        }
+
+        void push(T &&e) {
+            emplace(std::move(e));
+        }
+
+        /**
+         * construct the element in its node from args
+         */
+        template<class... Args>
+        void emplace(Args &&... args) {
+            _append(new Node(std::forward<Args>(args)...));
+            ++_size;
+        }
+
+        void pop() {
+            if (!root) {
+                throw container_is_empty();
+            }
+            Node *bucket[maxRank] = {};
+            for (Node *i = root, *j; i; i = j) {
+                j = i->next;
+                if (i != best) _place(bucket, i);
+            }
+            for (Node *i = best->child, *j; i; i = j) {
+                j = i->next;
+                _place(bucket, i);
+            }
+            delete best;
+            --_size;
+            root = tail = best = nullptr;
+            for (size_t i = 0; i < maxRank; ++i)
+                if (bucket[i]) _append(bucket[i]);
+        }
+
+        /**
+         * pop and return the top element, which is moved out instead of copied
+         */
+        T pop_value() {
+            if (!root) {
+                throw container_is_empty();
+            }
+            T res(std::move(best->value));
+            pop();
+            return res;
+        }
+
+        size_t size() const {
+            return _size;
+        }
+
+        bool empty() const {
+            return (_size == 0);
+        }
+
+        /**
+         * O(1), other is empty afterwards
+         */
+        void merge(priority_queue &other) {
+            if (this == &other || !other.root) return;
+            if (!root) {
+                root = other.root;
+                best = other.best;
+            }
+            else {
+                tail->next = other.root;
+                if (cmp(best->value, other.best->value)) best = other.best;
+            }
+            tail = other.tail;
+            _size += other._size;
+            other.root = other.tail = other.best = nullptr;
+            other._size = 0;
+        }
+    };
+
 }
 
 #endif
@@ -0,0 +1,169 @@
+/**
+ * implement a monotone priority queue for unsigned integral keys
+ */
+#ifndef SJTU_RADIX_HEAP_HPP
+#define SJTU_RADIX_HEAP_HPP
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include "utility.hpp"
+#include "exceptions.hpp"
+
+namespace sjtu {
+
+    /**
+     * a radix heap: the least key comes first, and no key less than the last one
+     * returned by top() or pop() may be pushed, as in Dijkstra or a timer queue.
+     * an element is kept in the bucket of the highest bit where its key differs from that last key,
+     * and moves only to lower buckets, so it is moved O(bits) times in all and no keys are compared in push.
+     */
+    template<class Key, class Value>
+    class radix_heap {
+        static_assert(std::is_integral<Key>::value && std::is_unsigned<Key>::value,
+                      "radix_heap needs an unsigned integral Key");
+
+    public:
+        typedef pair<Key, Value> value_type;
+
+    private:
+        static const size_t bits = sizeof(Key) * 8;
+
+        //an array of elements relocated by move construction, pair is not assignable
+        class Bucket {
+        public:
+            value_type *data;
+            size_t size, capacity;
+
+            Bucket() : data(nullptr), size(0), capacity(0) {}
+
+            Bucket(const Bucket &other) : data(nullptr), size(0), capacity(0) {
+                *this = other;
+            }
+
+            ~Bucket() {
+                clear();
+                ::operator delete(data);
+            }
+
+            Bucket &operator=(const Bucket &other) {
+                if (this == &other) return *this;
+                clear();
+                reserve(other.size);
+                for (; size < other.size; ++size) new(data + size) value_type(other.data[size]);
+                return *this;
+            }
+
+            void reserve(size_t cap) {
+                if (cap <= capacity) return;
+                value_type *tmp = static_cast<value_type *>(::operator new(cap * sizeof(value_type)));
+                for (size_t i = 0; i < size; ++i) {
+                    new(tmp + i) value_type(std::move(data[i]));
+                    data[i].~value_type();
+                }
+                ::operator delete(data);
+                data = tmp;
+                capacity = cap;
+            }
+
+            void push(value_type &&e) {
+                if (size == capacity) reserve(capacity ? capacity << 1 : 8);
+                new(data + size++) value_type(std::move(e));
+            }
+
+            void pop() {
+                data[--size].~value_type();
+            }
+
+            void clear() {
+                for (size_t i = 0; i < size; ++i) data[i].~value_type();
+                size = 0;
+            }
+        };
+
+        //bucket[0] holds the keys equal to last, bucket[i] those differing from it first at bit i - 1
+        mutable Bucket bucket[bits + 1];
+        mutable Key last;
+        size_t _size;
+
+        size_t index(const Key &key) const {
+            if (key == last) return 0;
+#if defined(__GNUC__)
+            return 64 - __builtin_clzll((unsigned long long) (key ^ last));
+#else
+            size_t res = 0;
+            for (Key diff = key ^ last; diff; diff >>= 1) ++res;
+            return res;
+#endif
+        }
+
+        //make the least key last and spread its bucket into the lower ones
+        void _pull() const {
+            if (bucket[0].size) return;
+            size_t i = 1;
+            while (!bucket[i].size) ++i;
+            Bucket &from = bucket[i];
+            last = from.data[0].first;
+            for (size_t j = 1; j < from.size; ++j)
+                if (from.data[j].first < last) last = from.data[j].first;
+            for (size_t j = 0; j < from.size; ++j) bucket[index(from.data[j].first)].push(std::move(from.data[j]));
+            from.clear();
+        }
+
+    public:
+        radix_heap() : last(0), _size(0) {}
+
+        /**
+         * the least key and its value.
+         * throw container_is_empty if empty
+         */
+        const value_type &top() const {
+            if (!_size) {
+                throw container_is_empty();
+            }
+            _pull();
+            return bucket[0].data[bucket[0].size - 1];
+        }
+
+        /**
+         * throw runtime_error if key is less than the last key returned by top() or pop()
+         */
+        void push(const Key &key, const Value &value) {
+            if (key < last) throw runtime_error();
+            bucket[index(key)].push(value_type(key, value));
+            ++_size;
+        }
+
+        /**
+         * throw container_is_empty if empty
+         */
+        void pop() {
+            if (!_size) {
+                throw container_is_empty();
+            }
+            _pull();
+            bucket[0].pop();
+            --_size;
+        }
+
+        size_t size() const {
+            return _size;
+        }
+
+        bool empty() const {
+            return _size == 0;
+        }
+
+        /**
+         * remove every element, and any key may be pushed again
+         */
+        void clear() {
+            for (size_t i = 0; i <= bits; ++i) bucket[i].clear();
+            last = 0;
+            _size = 0;
+        }
+    };
+
+}
+
+#endif
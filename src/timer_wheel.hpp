@@ -0,0 +1,355 @@
+/**
+ * implement a hierarchical timing wheel
+ */
+#ifndef SJTU_TIMER_WHEEL_HPP
+#define SJTU_TIMER_WHEEL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "exceptions.hpp"
+#include "priority_queue.hpp"
+
+namespace sjtu {
+
+    /**
+     * timers on an integer clock in 4 wheels of 256 slots.
+     * a timer is kept in the wheel of the highest byte where its deadline differs from the current time,
+     * at the slot of that byte, and moves to a lower wheel when the time reaches its slot.
+     * schedule and cancel are O(1), and advance costs O(1) for each timer fired, each occupied slot
+     * passed and each move between wheels, however far the time jumps.
+     * deadlines 2^32 or more ticks away wait in a priority_queue until the time gets close.
+     */
+    template<class Payload>
+    class timer_wheel {
+    private:
+        static const size_t levels = 4, slotBits = 8, slots = 1 << slotBits;
+        static const size_t chunkBits = 10, chunkSize = 1 << chunkBits;
+        static const uint32_t nil = UINT32_MAX;
+        //list ids after the wheel slots
+        static const uint32_t dueList = levels * slots, firingList = dueList + 1, lists = firingList + 1;
+
+        enum state_type {
+            unused, listed, spilled, firing
+        };
+
+        //nodes are allocated in chunks that never move, and linked by index
+        class Node {
+        public:
+            uint64_t deadline;
+            uint32_t prev, next, list, generation;
+            state_type state;
+            typename std::aligned_storage<sizeof(Payload), alignof(Payload)>::type storage;
+
+            Payload &payload() {
+                return *reinterpret_cast<Payload *>(&storage);
+            }
+        };
+
+        //an entry of the spill queue, the earliest deadline on top; stale once the generation changes
+        class Spill {
+        public:
+            uint64_t deadline;
+            uint32_t index, generation;
+
+            bool operator<(const Spill &rhs) const {
+                return deadline > rhs.deadline;
+            }
+        };
+
+        Node **chunks;
+        size_t chunkCount, chunkCapacity;
+        uint32_t allocated, freeList;
+
+        uint32_t head[lists];
+        //occupied slots of each wheel
+        uint64_t occupied[levels][slots / 64];
+        priority_queue<Spill> spill;
+
+        uint64_t current;
+        size_t _size;
+
+        Node &node(uint32_t index) const {
+            return chunks[index >> chunkBits][index & (chunkSize - 1)];
+        }
+
+        static size_t highestBit(uint64_t x) {
+#if defined(__GNUC__)
+            return 63 - __builtin_clzll(x);
+#else
+            size_t res = 0;
+            while (x >>= 1) ++res;
+            return res;
+#endif
+        }
+
+        //the first occupied slot of a wheel from slot from on, slots for none
+        size_t nextSlot(size_t level, size_t from) const {
+            for (size_t word = from >> 6; word < slots / 64; ++word) {
+                uint64_t bits = occupied[level][word];
+                if (word == from >> 6) bits &= ~(uint64_t) 0 << (from & 63);
+                if (!bits) continue;
+#if defined(__GNUC__)
+                return (word << 6) + __builtin_ctzll(bits);
+#else
+                size_t res = word << 6;
+                while (!(bits & 1)) bits >>= 1, ++res;
+                return res;
+#endif
+            }
+            return slots;
+        }
+
+        uint32_t _allocate() {
+            if (freeList != nil) {
+                uint32_t res = freeList;
+                freeList = node(res).next;
+                return res;
+            }
+            if (allocated == chunkCount * chunkSize) {
+                if (chunkCount == chunkCapacity) {
+                    chunkCapacity = chunkCapacity ? chunkCapacity << 1 : 8;
+                    Node **tmp = new Node *[chunkCapacity];
+                    for (size_t i = 0; i < chunkCount; ++i) tmp[i] = chunks[i];
+                    delete[] chunks;
+                    chunks = tmp;
+                }
+                chunks[chunkCount] = static_cast<Node *>(::operator new(chunkSize * sizeof(Node)));
+                for (size_t i = 0; i < chunkSize; ++i) {
+                    chunks[chunkCount][i].generation = 1;
+                    chunks[chunkCount][i].state = unused;
+                }
+                ++chunkCount;
+            }
+            return allocated++;
+        }
+
+        //destroy the payload and invalidate the handles of the node
+        void _release(uint32_t index) {
+            Node &ptr = node(index);
+            ptr.payload().~Payload();
+            ptr.state = unused;
+            ++ptr.generation;
+            ptr.next = freeList;
+            freeList = index;
+            --_size;
+        }
+
+        void _link(uint32_t index, uint32_t list) {
+            Node &ptr = node(index);
+            ptr.state = listed;
+            ptr.list = list;
+            ptr.prev = nil;
+            ptr.next = head[list];
+            if (head[list] != nil) node(head[list]).prev = index;
+            else if (list < dueList) occupied[list / slots][(list % slots) >> 6] |= (uint64_t) 1 << (list & 63);
+            head[list] = index;
+        }
+
+        void _unlink(uint32_t index) {
+            Node &ptr = node(index);
+            if (ptr.prev != nil) node(ptr.prev).next = ptr.next;
+            else {
+                head[ptr.list] = ptr.next;
+                if (ptr.next == nil && ptr.list < dueList)
+                    occupied[ptr.list / slots][(ptr.list % slots) >> 6] &= ~((uint64_t) 1 << (ptr.list & 63));
+            }
+            if (ptr.next != nil) node(ptr.next).prev = ptr.prev;
+        }
+
+        //put a node where its deadline belongs relative to the current time
+        void _place(uint32_t index) {
+            Node &ptr = node(index);
+            if (ptr.deadline <= current) {
+                _link(index, dueList);
+                return;
+            }
+            uint64_t diff = ptr.deadline ^ current;
+            if (diff >> (levels * slotBits)) {
+                ptr.state = spilled;
+                spill.push(Spill{ptr.deadline, index, ptr.generation});
+                return;
+            }
+            size_t level = highestBit(diff) / slotBits;
+            _link(index, level * slots + ((ptr.deadline >> (level * slotBits)) & (slots - 1)));
+        }
+
+        //detach a whole list, then place or fire its nodes one by one
+        template<class Function>
+        void _drain(uint32_t list, Function fn) {
+            uint32_t index = head[list];
+            head[list] = nil;
+            if (list < dueList) occupied[list / slots][(list % slots) >> 6] &= ~((uint64_t) 1 << (list & 63));
+            for (uint32_t j = index; j != nil; j = node(j).next) node(j).list = firingList;
+            head[firingList] = index;
+            while (head[firingList] != nil) {
+                index = head[firingList];
+                _unlink(index);
+                fn(index);
+            }
+        }
+
+        //the time of the next slot to reach, or of the next spilled deadline; UINT64_MAX for none
+        uint64_t _nextEvent() {
+            for (size_t level = 0; level < levels; ++level) {
+                size_t shift = level * slotBits;
+                size_t slot = nextSlot(level, ((current >> shift) & (slots - 1)) + 1);
+                if (slot < slots) return ((current >> (shift + slotBits)) << (shift + slotBits)) | ((uint64_t) slot << shift);
+            }
+            if (spill.empty()) return UINT64_MAX;
+            uint64_t epoch = spill.top().deadline >> (levels * slotBits) << (levels * slotBits);
+            return epoch > current ? epoch : current + 1;
+        }
+
+        class Replace {
+        public:
+            timer_wheel *wheel;
+
+            void operator()(uint32_t index) const {
+                wheel->_place(index);
+            }
+        };
+
+        template<class Function>
+        class Fire {
+        public:
+            timer_wheel *wheel;
+            Function *fn;
+            size_t *fired;
+
+            void operator()(uint32_t index) const {
+                Node &ptr = wheel->node(index);
+                ptr.state = firing;
+                (*fn)(ptr.payload());
+                wheel->_release(index);
+                ++*fired;
+            }
+        };
+
+    public:
+        /**
+         * refers to a timer until it fires or is cancelled, a stale handle is detected
+         */
+        class handle {
+            friend class timer_wheel;
+
+        private:
+            uint32_t index, generation;
+
+            handle(uint32_t i, uint32_t g) : index(i), generation(g) {}
+
+        public:
+            handle() : index(0), generation(0) {}
+
+            bool operator==(const handle &rhs) const {
+                return index == rhs.index && generation == rhs.generation;
+            }
+
+            bool operator!=(const handle &rhs) const {
+                return !(*this == rhs);
+            }
+        };
+
+        explicit timer_wheel(uint64_t start = 0)
+                : chunks(nullptr), chunkCount(0), chunkCapacity(0), allocated(0), freeList(nil), current(start), _size(0) {
+            for (size_t i = 0; i < lists; ++i) head[i] = nil;
+            for (size_t i = 0; i < levels; ++i)
+                for (size_t j = 0; j < slots / 64; ++j) occupied[i][j] = 0;
+        }
+
+        timer_wheel(const timer_wheel &other) = delete;
+
+        timer_wheel &operator=(const timer_wheel &other) = delete;
+
+        ~timer_wheel() {
+            for (uint32_t i = 0; i < allocated; ++i)
+                if (node(i).state != unused) node(i).payload().~Payload();
+            for (size_t i = 0; i < chunkCount; ++i) ::operator delete(chunks[i]);
+            delete[] chunks;
+        }
+
+        /**
+         * a timer firing at the first advance reaching deadline, or at the next advance if deadline has passed
+         */
+        handle schedule(uint64_t deadline, const Payload &payload) {
+            uint32_t index = _allocate();
+            Node &ptr = node(index);
+            new(&ptr.storage) Payload(payload);
+            ptr.deadline = deadline;
+            ++_size;
+            _place(index);
+            return handle(index, ptr.generation);
+        }
+
+        /**
+         * false if the timer has fired, is firing or was cancelled
+         */
+        bool cancel(const handle &h) {
+            if (h.index >= allocated) return false;
+            Node &ptr = node(h.index);
+            if (ptr.generation != h.generation) return false;
+            if (ptr.state == listed) _unlink(h.index);
+            else if (ptr.state != spilled) return false;
+            //a spilled entry stays in the queue and is skipped by its generation
+            _release(h.index);
+            return true;
+        }
+
+        /**
+         * move the time to now and call fn(Payload &) for every timer due, in the order of the time.
+         * fn may schedule and cancel timers, a timer it schedules at or before the current time fires
+         * after the current slot, within this advance if the time moves on and at the next one otherwise.
+         * throw runtime_error if now is earlier than the current time
+         */
+        template<class Function>
+        size_t advance(uint64_t now, Function fn) {
+            if (now < current) throw runtime_error();
+            size_t fired = 0;
+            Fire<Function> fire = {this, &fn, &fired};
+            Replace replace = {this};
+            _drain(dueList, fire);
+            while (current < now) {
+                uint64_t next = _nextEvent();
+                if (next > now) {
+                    current = now;
+                    break;
+                }
+                current = next;
+                //slots whose range starts now move down, from the highest wheel
+                for (size_t level = levels - 1; level > 0; --level) {
+                    size_t shift = level * slotBits;
+                    if (current & (((uint64_t) 1 << shift) - 1)) continue;
+                    _drain(level * slots + ((current >> shift) & (slots - 1)), replace);
+                }
+                while (!spill.empty() && spill.top().deadline >> (levels * slotBits) <= current >> (levels * slotBits)) {
+                    Spill entry = spill.top();
+                    spill.pop();
+                    if (node(entry.index).generation == entry.generation) _place(entry.index);
+                }
+                _drain(current & (slots - 1), fire);
+                _drain(dueList, fire);
+            }
+            return fired;
+        }
+
+        uint64_t now() const {
+            return current;
+        }
+
+        /**
+         * the number of timers scheduled and neither fired nor cancelled
+         */
+        size_t size() const {
+            return _size;
+        }
+
+        bool empty() const {
+            return _size == 0;
+        }
+    };
+
+}
+
+#endif
@@ -0,0 +1,209 @@
+/**
+ * implement a container keeping the greatest K elements of a stream
+ */
+#ifndef SJTU_TOP_K_HPP
+#define SJTU_TOP_K_HPP
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <utility>
+#include "exceptions.hpp"
+
+namespace sjtu {
+
+    /**
+     * keeps the K greatest elements pushed so far, in the order of Compare as priority_queue does.
+     * the kept elements form a 4-ary heap with the least of them on top, in K slots allocated once,
+     * so an element not greater than the K-th is rejected by one comparison,
+     * and an accepted one replaces the K-th in a single sift.
+     */
+    template<typename T, class Compare = std::less<T>>
+    class top_k {
+    private:
+        static const size_t D = 4;
+
+        Compare cmp;
+        T *heap;
+        size_t _size, k;
+
+        //the heap is ordered by worse, heap[0] is the least element kept
+        bool worse(const T &a, const T &b) const {
+            return cmp(a, b);
+        }
+
+        void _sift_up(size_t hole, T &value) {
+            while (hole) {
+                size_t parent = (hole - 1) / D;
+                if (!worse(value, heap[parent])) break;
+                heap[hole] = std::move(heap[parent]);
+                hole = parent;
+            }
+            heap[hole] = std::move(value);
+        }
+
+        void _sift_down(size_t hole, T &value) {
+            while (true) {
+                size_t first = hole * D + 1, least = first;
+                if (first >= _size) break;
+                size_t last = (first + D < _size) ? first + D : _size;
+                for (size_t i = first + 1; i < last; ++i)
+                    if (worse(heap[i], heap[least])) least = i;
+                if (!worse(heap[least], value)) break;
+                heap[hole] = std::move(heap[least]);
+                hole = least;
+            }
+            heap[hole] = std::move(value);
+        }
+
+        template<class U>
+        bool _push(U &&e) {
+            if (_size < k) {
+                new(heap + _size) T(std::forward<U>(e));
+                T value(std::move(heap[_size]));
+                _sift_up(_size++, value);
+                return true;
+            }
+            if (!k || !worse(heap[0], e)) return false;
+            T value(std::forward<U>(e));
+            _sift_down(0, value);
+            return true;
+        }
+
+        void _release() {
+            for (size_t i = 0; i < _size; ++i) heap[i].~T();
+            ::operator delete(heap);
+        }
+
+        //for the copy constructor only, the elements copied so far are destroyed if one throws
+        void _copy(const top_k &other) {
+            T *buffer = static_cast<T *>(::operator new(other.k * sizeof(T)));
+            size_t n = 0;
+            try {
+                for (; n < other._size; ++n) new(buffer + n) T(other.heap[n]);
+            } catch (...) {
+                for (size_t i = 0; i < n; ++i) buffer[i].~T();
+                ::operator delete(buffer);
+                throw;
+            }
+            heap = buffer, _size = n, k = other.k;
+        }
+
+    public:
+        explicit top_k(size_t K, const Compare &comp = Compare()) : cmp(comp), _size(0), k(K) {
+            heap = static_cast<T *>(::operator new(k * sizeof(T)));
+        }
+
+        top_k(const top_k &other) : cmp(other.cmp) {
+            _copy(other);
+        }
+
+        /**
+         * O(1), other keeps nothing and rejects everything afterwards
+         */
+        top_k(top_k &&other) : cmp(std::move(other.cmp)), heap(other.heap), _size(other._size), k(other.k) {
+            other.heap = nullptr;
+            other._size = other.k = 0;
+        }
+
+        ~top_k() {
+            _release();
+        }
+
+        //this is left untouched if a copy throws
+        top_k &operator=(const top_k &other) {
+            if (this == &other) return *this;
+            top_k tmp(other);
+            return *this = std::move(tmp);
+        }
+
+        top_k &operator=(top_k &&other) {
+            if (this == &other) return *this;
+            _release();
+            cmp = std::move(other.cmp);
+            heap = other.heap;
+            _size = other._size;
+            k = other.k;
+            other.heap = nullptr;
+            other._size = other.k = 0;
+            return *this;
+        }
+
+        /**
+         * keep e if fewer than K elements are kept or e is greater than the least of them,
+         * which is dropped then. false for rejected
+         */
+        bool push(const T &e) {
+            return _push(e);
+        }
+
+        bool push(T &&e) {
+            return _push(std::move(e));
+        }
+
+        /**
+         * the least element kept, the K-th greatest once full.
+         * throw container_is_empty if nothing is kept
+         */
+        const T &threshold() const {
+            if (!_size) {
+                throw container_is_empty();
+            }
+            return heap[0];
+        }
+
+        size_t size() const {
+            return _size;
+        }
+
+        size_t capacity() const {
+            return k;
+        }
+
+        bool empty() const {
+            return _size == 0;
+        }
+
+        bool full() const {
+            return _size == k;
+        }
+
+        void clear() {
+            for (size_t i = 0; i < _size; ++i) heap[i].~T();
+            _size = 0;
+        }
+
+        /**
+         * move the kept elements to out from the greatest to the least and keep nothing.
+         * the heap is sorted in place, O(K log K) without extra memory
+         */
+        template<class OutputIterator>
+        OutputIterator take_sorted(OutputIterator out) {
+            size_t n = _size;
+            while (_size > 1) {
+                T least(std::move(heap[0]));
+                T value(std::move(heap[--_size]));
+                _sift_down(0, value);
+                heap[_size] = std::move(least);
+            }
+            for (size_t i = 0; i < n; ++i, ++out) {
+                *out = std::move(heap[i]);
+                heap[i].~T();
+            }
+            _size = 0;
+            return out;
+        }
+
+        /**
+         * copy the kept elements to out from the greatest to the least
+         */
+        template<class OutputIterator>
+        OutputIterator sorted(OutputIterator out) const {
+            top_k tmp(*this);
+            return tmp.take_sorted(out);
+        }
+    };
+
+}
+
+#endif
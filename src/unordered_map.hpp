@@ -0,0 +1,526 @@
+/**
+ * implement a container like std::unordered_map
+ */
+#ifndef SJTU_UNORDERED_MAP_HPP
+#define SJTU_UNORDERED_MAP_HPP
+
+// only for std::hash<T> and std::equal_to<T>
+#include <functional>
+#include <cstddef>
+#include <new>
+#include "utility.hpp"
+#include "exceptions.hpp"
+
+namespace sjtu {
+
+    /**
+     * a hash map with open addressing and Robin Hood probing: the elements stay in one array
+     * in the order of their home slots, so a lookup reads a few neighbouring slots at most and
+     * stops as soon as it meets an element closer to its home than the key would be.
+     * erase() shifts the following elements back instead of leaving tombstones.
+     * insert() and erase() may move elements, which invalidates every iterator.
+     * a hash sending too many keys near one slot makes insertion throw runtime_error
+     * once growing the table no longer spreads them.
+     */
+    template<
+            class Key,
+            class T,
+            class Hash = std::hash<Key>,
+            class Equal = std::equal_to<Key>
+    >
+    class unordered_map {
+    public:
+        typedef pair<const Key, T> value_type;
+
+    private:
+        static const size_t minCapacity = 8;
+        //a probe sequence reaching this long makes the table grow
+        static const unsigned maxDistance = 255;
+        //but not below this load factor, where growing will not help a bad hash
+        static const size_t minLoadInverse = 8;
+
+        //raw memory, the element in slot i is alive iff dist[i] != 0.
+        //a moved-from map has no table until it is inserted into
+        value_type *slots;
+        //0 for an empty slot, the probe length of the element plus 1 otherwise
+        unsigned char *dist;
+        size_t capacity, mask, _size;
+        int shift;
+        Hash hash;
+        Equal equal;
+
+        //the map is left untouched if an allocation throws
+        void allocate(size_t cap) {
+            value_type *newSlots = static_cast<value_type *>(::operator new(cap * sizeof(value_type)));
+            try {
+                dist = new unsigned char[cap]();
+            } catch (...) {
+                ::operator delete(newSlots);
+                throw;
+            }
+            slots = newSlots;
+            capacity = cap, mask = cap - 1, _size = 0;
+            shift = 64;
+            for (size_t i = cap; i > 1; i >>= 1) --shift;
+        }
+
+        void makeEmpty() {
+            slots = nullptr, dist = nullptr;
+            capacity = mask = _size = 0, shift = 64;
+        }
+
+        //take the table of other, which is left without one
+        void steal(unordered_map &other) {
+            slots = other.slots, dist = other.dist;
+            capacity = other.capacity, mask = other.mask, _size = other._size, shift = other.shift;
+            other.makeEmpty();
+        }
+
+        void release() {
+            for (size_t i = 0; i < capacity; ++i)
+                if (dist[i]) slots[i].~value_type();
+            ::operator delete(slots);
+            delete[] dist;
+        }
+
+        //fibonacci hashing spreads the identity hash of integers over the table
+        size_t homeOf(const Key &key) const {
+            unsigned long long h = hash(key);
+            return (size_t) ((h * 0x9E3779B97F4A7C15ull) >> shift);
+        }
+
+        size_t nextOf(size_t i) const {
+            return (i + 1) & mask;
+        }
+
+        //slot of key, capacity for not found
+        size_t locate(const Key &key) const {
+            if (!capacity) return capacity;
+            size_t i = homeOf(key);
+            for (unsigned d = 1; dist[i] >= d; i = nextOf(i), ++d)
+                if (dist[i] == d && equal(slots[i].first, key)) return i;
+            return capacity;
+        }
+
+        //shift the elements after the hole in slot i back by one, until one is at its home
+        void closeGap(size_t i) {
+            dist[i] = 0;
+            for (size_t j = nextOf(i); dist[j] > 1; i = j, j = nextOf(j)) {
+                new(slots + i) value_type(std::move(slots[j]));
+                slots[j].~value_type();
+                dist[i] = dist[j] - 1, dist[j] = 0;
+            }
+        }
+
+        //make room for key which does not exist, the returned slot is raw memory.
+        //capacity if some probe sequence would reach maxDistance
+        size_t makeRoom(const Key &key) {
+            size_t i = homeOf(key), j;
+            unsigned d = 1;
+            while (dist[i] >= d) i = nextOf(i), ++d;
+            for (j = i; dist[j] && dist[j] + 1u < maxDistance; j = nextOf(j));
+            if (d >= maxDistance || dist[j]) return capacity;
+            //the elements in [i, j) are poorer than key, move them forward by one
+            for (size_t k = j, p; k != i; k = p) {
+                p = (k - 1) & mask;
+                new(slots + k) value_type(std::move(slots[p]));
+                slots[p].~value_type();
+                dist[k] = dist[p] + 1;
+            }
+            dist[i] = d;
+            return i;
+        }
+
+        void resize(size_t cap) {
+            value_type *oldSlots = slots;
+            unsigned char *oldDist = dist;
+            size_t oldCapacity = capacity, oldSize = _size;
+            allocate(cap);
+            //the homes keep their order and spread apart, so no probe sequence gets longer and makeRoom succeeds
+            for (size_t i = 0; i < oldCapacity; ++i) {
+                if (!oldDist[i]) continue;
+                size_t k = makeRoom(oldSlots[i].first);
+                new(slots + k) value_type(std::move(oldSlots[i]));
+                oldSlots[i].~value_type();
+            }
+            _size = oldSize;
+            ::operator delete(oldSlots);
+            delete[] oldDist;
+        }
+
+        //for the copy constructor only, the elements copied so far are destroyed if one throws
+        void copyFrom(const unordered_map &other) {
+            if (!other.capacity) {
+                makeEmpty();
+                return;
+            }
+            allocate(other.capacity);
+            try {
+                for (size_t i = 0; i < capacity; ++i) {
+                    if (!other.dist[i]) continue;
+                    new(slots + i) value_type(other.slots[i]);
+                    dist[i] = other.dist[i];
+                }
+            } catch (...) {
+                release();
+                throw;
+            }
+            _size = other._size;
+        }
+
+        //pair copies whatever its converting constructor is given, while this converts to
+        //an rvalue of T, so a new element is moved into its slot
+        class Mover {
+        public:
+            T *value;
+
+            operator T() const {
+                return std::move(*value);
+            }
+        };
+
+        //false for failing to insert because same key has existed.
+        //the value is built before the table changes, so args may refer into the map
+        template<class... Args>
+        pair<size_t, bool> emplaceKey(const Key &key, Args &&... args) {
+            size_t i = locate(key);
+            if (i != capacity) return pair<size_t, bool>(i, false);
+            T value(std::forward<Args>(args)...);
+            if (!capacity) allocate(minCapacity);
+            else if ((_size + 1) * 8 > capacity * 7) resize(capacity << 1);
+            while ((i = makeRoom(key)) == capacity) {
+                if (_size * minLoadInverse < capacity) throw runtime_error();
+                resize(capacity << 1);
+            }
+            try {
+                new(slots + i) value_type(key, Mover{&value});
+            } catch (...) {
+                closeGap(i);
+                throw;
+            }
+            ++_size;
+            return pair<size_t, bool>(i, true);
+        }
+
+        //the first alive slot from i, capacity for none
+        size_t skipEmpty(size_t i) const {
+            while (i < capacity && !dist[i]) ++i;
+            return i;
+        }
+
+    public:
+        class const_iterator;
+
+        class iterator {
+            friend unordered_map;
+        private:
+            size_t index;
+            const unordered_map *source;
+        public:
+
+            iterator(size_t index, const unordered_map *source) : index(index), source(source) {}
+
+            iterator() : index(0), source(nullptr) {}
+
+            iterator(const iterator &other) : index(other.index), source(other.source) {}
+
+            /**
+             * throw invalid_iterator if iterator is end()
+             */
+            iterator operator++(int) {
+                iterator tmp(*this);
+                ++*this;
+                return tmp;
+            }
+
+            iterator &operator++() {
+                if (source == nullptr || index >= source->capacity) throw invalid_iterator();
+                index = source->skipEmpty(index + 1);
+                return *this;
+            }
+
+            /**
+             * throw invalid_iterator if iterator is begin()
+             */
+            iterator operator--(int) {
+                iterator tmp(*this);
+                --*this;
+                return tmp;
+            }
+
+            iterator &operator--() {
+                if (source == nullptr) throw invalid_iterator();
+                size_t i = index;
+                do {
+                    if (i == 0) throw invalid_iterator();
+                } while (!source->dist[--i]);
+                index = i;
+                return *this;
+            }
+
+            value_type &operator*() const {
+                if (source == nullptr || index >= source->capacity) throw invalid_iterator();
+                return source->slots[index];
+            }
+
+            bool operator==(const iterator &rhs) const {
+                return (index == rhs.index && source == rhs.source);
+            }
+
+            bool operator==(const const_iterator &rhs) const {
+                return (index == rhs.index && source == rhs.source);
+            }
+
+            bool operator!=(const iterator &rhs) const {
+                return (index != rhs.index || source != rhs.source);
+            }
+
+            bool operator!=(const const_iterator &rhs) const {
+                return (index != rhs.index || source != rhs.source);
+            }
+
+            value_type *operator->() const noexcept {
+                return source->slots + index;
+            }
+        };
+
+        class const_iterator {
+            friend unordered_map;
+        private:
+            size_t index;
+            const unordered_map *source;
+        public:
+
+            const_iterator() : index(0), source(nullptr) {}
+
+            const_iterator(const const_iterator &other) : index(other.index), source(other.source) {}
+
+            const_iterator(const iterator &other) : index(other.index), source(other.source) {}
+
+            const_iterator operator++(int) {
+                const_iterator tmp(*this);
+                ++*this;
+                return tmp;
+            }
+
+            const_iterator &operator++() {
+                if (source == nullptr || index >= source->capacity) throw invalid_iterator();
+                index = source->skipEmpty(index + 1);
+                return *this;
+            }
+
+            const_iterator operator--(int) {
+                const_iterator tmp(*this);
+                --*this;
+                return tmp;
+            }
+
+            const_iterator &operator--() {
+                if (source == nullptr) throw invalid_iterator();
+                size_t i = index;
+                do {
+                    if (i == 0) throw invalid_iterator();
+                } while (!source->dist[--i]);
+                index = i;
+                return *this;
+            }
+
+            const value_type &operator*() const {
+                if (source == nullptr || index >= source->capacity) throw invalid_iterator();
+                return source->slots[index];
+            }
+
+            bool operator==(const iterator &rhs) const {
+                return (index == rhs.index && source == rhs.source);
+            }
+
+            bool operator==(const const_iterator &rhs) const {
+                return (index == rhs.index && source == rhs.source);
+            }
+
+            bool operator!=(const iterator &rhs) const {
+                return (index != rhs.index || source != rhs.source);
+            }
+
+            bool operator!=(const const_iterator &rhs) const {
+                return (index != rhs.index || source != rhs.source);
+            }
+
+            const value_type *operator->() const noexcept {
+                return source->slots + index;
+            }
+        };
+
+        explicit unordered_map(const Hash &h = Hash(), const Equal &eq = Equal()) : hash(h), equal(eq) {
+            allocate(minCapacity);
+        }
+
+        unordered_map(const unordered_map &other) : hash(other.hash), equal(other.equal) {
+            copyFrom(other);
+        }
+
+        //other is left empty without a table, it allocates again on its next insertion
+        unordered_map(unordered_map &&other) : hash(other.hash), equal(other.equal) {
+            steal(other);
+        }
+
+        //this map is left untouched if a copy throws
+        unordered_map &operator=(const unordered_map &other) {
+            if (this == &other) return *this;
+            unordered_map tmp(other);
+            return *this = std::move(tmp);
+        }
+
+        unordered_map &operator=(unordered_map &&other) {
+            if (this == &other) return *this;
+            hash = other.hash, equal = other.equal;
+            release();
+            steal(other);
+            return *this;
+        }
+
+        ~unordered_map() {
+            release();
+        }
+
+        /**
+         * throw index_out_of_bound if key does not exist
+         */
+        T &at(const Key &key) {
+            size_t i = locate(key);
+            if (i == capacity) throw index_out_of_bound();
+            return slots[i].second;
+        }
+
+        const T &at(const Key &key) const {
+            size_t i = locate(key);
+            if (i == capacity) throw index_out_of_bound();
+            return slots[i].second;
+        }
+
+        T &operator[](const Key &key) {
+            size_t i = emplaceKey(key).first;
+            return slots[i].second;
+        }
+
+        const T &operator[](const Key &key) const {
+            return at(key);
+        }
+
+        iterator begin() {
+            return iterator(skipEmpty(0), this);
+        }
+
+        const_iterator begin() const {
+            return iterator(skipEmpty(0), this);
+        }
+
+        const_iterator cbegin() const {
+            return iterator(skipEmpty(0), this);
+        }
+
+        iterator end() {
+            return iterator(capacity, this);
+        }
+
+        const_iterator end() const {
+            return iterator(capacity, this);
+        }
+
+        const_iterator cend() const {
+            return iterator(capacity, this);
+        }
+
+        bool empty() const {
+            return _size == 0;
+        }
+
+        size_t size() const {
+            return _size;
+        }
+
+        size_t bucket_count() const {
+            return capacity;
+        }
+
+        void clear() {
+            for (size_t i = 0; i < capacity; ++i)
+                if (dist[i]) slots[i].~value_type(), dist[i] = 0;
+            _size = 0;
+        }
+
+        /**
+         * grow the table so that n elements fit without another resize
+         */
+        void reserve(size_t n) {
+            size_t cap = capacity ? capacity : minCapacity;
+            while (n * 8 > cap * 7) cap <<= 1;
+            if (cap != capacity) resize(cap);
+        }
+
+        /**
+         * the bool is false if the key has existed
+         */
+        pair<iterator, bool> insert(const value_type &value) {
+            pair<size_t, bool> tmp = emplaceKey(value.first, value.second);
+            return pair<iterator, bool>(iterator(tmp.first, this), tmp.second);
+        }
+
+        /**
+         * insert a value constructed from args if key does not exist,
+         * args are left untouched otherwise
+         */
+        template<class... Args>
+        pair<iterator, bool> try_emplace(const Key &key, Args &&... args) {
+            pair<size_t, bool> tmp = emplaceKey(key, std::forward<Args>(args)...);
+            return pair<iterator, bool>(iterator(tmp.first, this), tmp.second);
+        }
+
+        /**
+         * insert value or assign it to the existing element, the bool is true for insertion
+         */
+        pair<iterator, bool> insert_or_assign(const Key &key, const T &value) {
+            pair<size_t, bool> tmp = emplaceKey(key, value);
+            if (!tmp.second) slots[tmp.first].second = value;
+            return pair<iterator, bool>(iterator(tmp.first, this), tmp.second);
+        }
+
+        /**
+         * throw invalid_iterator if pos is end() or of another map.
+         * the next element may be shifted into pos, so do not increase pos afterwards
+         */
+        void erase(iterator pos) {
+            if (pos.source != this || pos.index >= capacity || !dist[pos.index]) throw invalid_iterator();
+            slots[pos.index].~value_type();
+            closeGap(pos.index);
+            --_size;
+        }
+
+        /**
+         * return the number of erased elements (0 or 1)
+         */
+        size_t erase(const Key &key) {
+            size_t i = locate(key);
+            if (i == capacity) return 0;
+            slots[i].~value_type();
+            closeGap(i);
+            --_size;
+            return 1;
+        }
+
+        size_t count(const Key &key) const {
+            return locate(key) != capacity;
+        }
+
+        iterator find(const Key &key) {
+            return iterator(locate(key), this);
+        }
+
+        const_iterator find(const Key &key) const {
+            return iterator(locate(key), this);
+        }
+    };
+
+}
+
+#endif